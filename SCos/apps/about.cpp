@@ -12,13 +12,6 @@
 
 #define MAKE_COLOR(fg, bg) ((bg << 4) | fg)
 
-// Utility functions
-static int about_strlen(const char* str) {
-    int len = 0;
-    while (str[len]) len++;
-    return len;
-}
-
 void openAbout() {
     // Clear the screen first
     uint8_t bg_color = MAKE_COLOR(COLOR_LIGHT_GRAY, COLOR_BLUE);
@@ -2,20 +2,6 @@
 #include "../ui/window_manager.hpp"
 #include <stdint.h>
 
-// Local string function implementations for freestanding environment
-static int app_store_strlen(const char* str) {
-    int len = 0;
-    while (str[len]) len++;
-    return len;
-}
-
-static void app_store_strcpy(char* dest, const char* src) {
-    while (*src) {
-        *dest++ = *src++;
-    }
-    *dest = '\0';
-}
-
 // App Store state
 static int store_window_id = -1;
 static bool store_visible = false;
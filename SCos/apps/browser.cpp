@@ -2,39 +2,25 @@
 #include "browser.hpp"
 #include "../ui/window_manager.hpp"
 #include <stdint.h>
+#include "../include/kstring.hpp"
+#include "../kernel/smp.hpp"
+#include "../kernel/fiber.hpp"
 
 // Browser state
 static int browser_window_id = -1;
 static bool browser_visible = false;
 static char current_url[256] = "scos://home";
 static char address_bar[256] = "scos://home";
-
-static int browser_strlen(const char* str) {
-    int len = 0;
-    while (str[len]) len++;
-    return len;
-}
-
-static void browser_strcpy(char* dest, const char* src) {
-    while (*src) {
-        *dest++ = *src++;
-    }
-    *dest = '\0';
-}
-
-static int browser_strcmp(const char* str1, const char* str2) {
-    while (*str1 && (*str1 == *str2)) {
-        str1++;
-        str2++;
-    }
-    return *(unsigned char*)str1 - *(unsigned char*)str2;
-}
+// Set while a page parses in the background; the interpreter's elements
+// are not safe to touch until pageLoaded() runs
+static volatile bool page_loading = false;
+static fiber_event page_parsed;
 
 void Browser::init() {
     browser_visible = false;
     browser_window_id = -1;
-    browser_strcpy(current_url, "scos://home");
-    browser_strcpy(address_bar, "scos://home");
+    str_copy(current_url, sizeof(current_url), "scos://home");
+    str_copy(address_bar, sizeof(address_bar), "scos://home");
     HTMLInterpreter::init();
 }
 
@@ -198,21 +184,19 @@ void Browser::handleMouseClick(int x, int y) {
             // Refresh button clicked
             refreshPage();
         }
-    } else {
+    } else if (!page_loading) {
         // Pass click to HTML interpreter for interactive elements
         HTMLInterpreter::handleClick(x - win->x, y - win->y);
     }
 }
 
 void Browser::navigate(const char* url) {
-    browser_strcpy(current_url, url);
-    browser_strcpy(address_bar, url);
+    StrView target(url);
+    str_copy(current_url, sizeof(current_url), target);
+    str_copy(address_bar, sizeof(address_bar), target);
     
     // Check if URL points to an HTML file
-    int url_len = browser_strlen(url);
-    if (url_len > 5 && browser_strcmp(url + url_len - 5, ".html") == 0) {
-        loadHTMLFile(url);
-    } else if (url_len > 4 && browser_strcmp(url + url_len - 4, ".htm") == 0) {
+    if (target.ends_with(".html") || target.ends_with(".htm")) {
         loadHTMLFile(url);
     } else {
         drawBrowser();
@@ -223,47 +207,74 @@ void Browser::refreshPage() {
     drawBrowser();
 }
 
+// For now the page is built in - in full implementation would read from filesystem
+static const char sample_html[] =
+    "<html>"
+    "<head><title>SCos Browser</title></head>"
+    "<body>"
+    "<h1 id='title' class='header'>Welcome to SCos Browser</h1>"
+    "<p>This browser now supports HTML, CSS, and JavaScript!</p>"
+    "<button id='click_me' onclick='alert()'>Click Me</button>"
+    "<div class='content'>"
+    "<p>Features:</p>"
+    "<ul>"
+    "<li>HTML parsing</li>"
+    "<li>CSS styling</li>"
+    "<li>JavaScript execution</li>"
+    "<li>Interactive elements</li>"
+    "</ul>"
+    "</div>"
+    "</body>"
+    "</html>";
+
+static const char sample_css[] =
+    "h1 { color: red; width: 40; }"
+    ".header { color: yellow; }"
+    ".content { color: green; }"
+    "button { color: white; }"
+    "p { color: blue; }";
+
+static const char sample_js[] =
+    "function alert() {"
+    "  // Simple alert simulation"
+    "}"
+    "function click_me_click() {"
+    "  // Button click handler"
+    "}";
+
 void Browser::loadHTMLFile(const char* filepath) {
-    // For now, create sample HTML content - in full implementation would read from filesystem
-    const char* sample_html = 
-        "<html>"
-        "<head><title>SCos Browser</title></head>"
-        "<body>"
-        "<h1 id='title' class='header'>Welcome to SCos Browser</h1>"
-        "<p>This browser now supports HTML, CSS, and JavaScript!</p>"
-        "<button id='click_me' onclick='alert()'>Click Me</button>"
-        "<div class='content'>"
-        "<p>Features:</p>"
-        "<ul>"
-        "<li>HTML parsing</li>"
-        "<li>CSS styling</li>"
-        "<li>JavaScript execution</li>"
-        "<li>Interactive elements</li>"
-        "</ul>"
-        "</div>"
-        "</body>"
-        "</html>";
-    
-    const char* sample_css = 
-        "h1 { color: red; width: 40; }"
-        ".header { color: yellow; }"
-        ".content { color: green; }"
-        "button { color: white; }"
-        "p { color: blue; }";
-    
-    const char* sample_js = 
-        "function alert() {"
-        "  // Simple alert simulation"
-        "}"
-        "function click_me_click() {"
-        "  // Button click handler"
-        "}";
-    
+    if (page_loading) return;
+
+    // Parse on another core so input and drawing carry on, with a fiber
+    // on the desktop thread waiting to draw the result. If the job queue
+    // is full, parse here instead.
+    page_loading = true;
+    if (!smp_submit(parsePage, nullptr, &page_parsed)) {
+        parsePage(nullptr);
+        fiber_signal(&page_parsed);
+    }
+    if (!fiber_create("html", awaitPage, nullptr)) {
+        while (!page_parsed.signalled) {
+            asm volatile("pause");
+        }
+        pageLoaded(nullptr);
+    }
+}
+
+void Browser::parsePage(void*) {
     HTMLInterpreter::reset();
     HTMLInterpreter::parseHTML(sample_html);
     HTMLInterpreter::parseCSS(sample_css);
     HTMLInterpreter::parseJS(sample_js);
-    
+}
+
+void Browser::awaitPage(void*) {
+    fiber_await_io(&page_parsed);
+    pageLoaded(nullptr);
+}
+
+void Browser::pageLoaded(void*) {
+    page_loading = false;
     renderHTMLPage();
 }
 
@@ -47,6 +47,9 @@ private:
     static void showHomePage();
     static void processUrl();
     static void loadHTMLFile(const char* filepath);
+    static void parsePage(void* data);
+    static void awaitPage(void* data);
+    static void pageLoaded(void* data);
     static void loadCSSFile(const char* filepath);
     static void loadJSFile(const char* filepath);
     static void renderHTMLPage();
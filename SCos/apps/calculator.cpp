@@ -3,6 +3,7 @@
 #include "../ui/window_manager.hpp"
 #include <stdint.h>
 #include <stdbool.h>
+#include "../include/kstring.hpp"
 
 // VGA constants
 #define VGA_WIDTH 80
@@ -65,46 +66,6 @@ static void sprintf(char* buffer, const char* format, double value) {
     buffer[buf_idx] = '\0';
 }
 
-// Local math and string functions for freestanding environment
-static int calc_strlen(const char* str) {
-    int len = 0;
-    while (str[len]) len++;
-    return len;
-}
-
-static void calc_strcpy(char* dest, const char* src) {
-    while (*src) {
-        *dest++ = *src++;
-    }
-    *dest = '\0';
-}
-
-static void calc_strcat(char* dest, const char* src) {
-    while (*dest) dest++;
-    while (*src) {
-        *dest++ = *src++;
-    }
-    *dest = '\0';
-}
-
-static int calc_atoi(const char* str) {
-    int result = 0;
-    int sign = 1;
-    int i = 0;
-
-    if (str[0] == '-') {
-        sign = -1;
-        i = 1;
-    }
-
-    while (str[i] >= '0' && str[i] <= '9') {
-        result = result * 10 + (str[i] - '0');
-        i++;
-    }
-
-    return sign * result;
-}
-
 static void int_to_str(int num, char* str) {
     if (num == 0) {
         str[0] = '0';
@@ -183,7 +144,7 @@ void drawCalculator() {
     // Display current number
     char display_str[32];
     sprintf(display_str, "%.2f", display_value);
-    vga_put_string(24 - calc_strlen(display_str), 5, display_str, MAKE_COLOR(COLOR_WHITE, COLOR_BLACK));
+    vga_put_string(24 - (int)strlen(display_str), 5, display_str, MAKE_COLOR(COLOR_WHITE, COLOR_BLACK));
 
     // Draw buttons
     const char* buttons[4][4] = {
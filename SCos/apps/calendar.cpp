@@ -1,5 +1,6 @@
 #include "calendar.hpp"
 #include "../ui/window_manager.hpp"
+#include "../include/string.h"
 #include <stdint.h>
 
 // Use color definitions from window_manager.hpp
@@ -53,38 +54,8 @@ static Event events[] = {
 #define NUM_EVENTS (sizeof(events) / sizeof(events[0]))
 
 // Utility functions
-static int calendar_strlen(const char* str) {
-    int len = 0;
-    while (str[len]) len++;
-    return len;
-}
-
 // center_text function is now provided by vga_utils.hpp
 
-static void int_to_string(int value, char* buffer) {
-    if (value == 0) {
-        buffer[0] = '0';
-        buffer[1] = '\0';
-        return;
-    }
-
-    int i = 0;
-    int temp = value;
-
-    while (temp > 0) {
-        buffer[i++] = '0' + (temp % 10);
-        temp /= 10;
-    }
-    buffer[i] = '\0';
-
-    // Reverse the string
-    for (int j = 0; j < i / 2; j++) {
-        char tmp = buffer[j];
-        buffer[j] = buffer[i - 1 - j];
-        buffer[i - 1 - j] = tmp;
-    }
-}
-
 // Date calculation functions
 static int is_leap_year(int year) {
     return (year % 4 == 0 && year % 100 != 0) || (year % 400 == 0);
@@ -133,20 +104,7 @@ static void draw_calendar_header() {
 
     // Month and year title
     char title[50];
-    char year_str[8];
-    int_to_string(view_date.year, year_str);
-
-    // Build title string
-    int pos = 0;
-    const char* month_name = month_names[view_date.month - 1];
-    for (int i = 0; month_name[i] && pos < 45; i++) {
-        title[pos++] = month_name[i];
-    }
-    title[pos++] = ' ';
-    for (int i = 0; year_str[i] && pos < 49; i++) {
-        title[pos++] = year_str[i];
-    }
-    title[pos] = '\0';
+    snprintf(title, sizeof(title), "%s %d", month_names[view_date.month - 1], view_date.year);
 
     center_text(1, title, title_color);
 
@@ -187,13 +145,7 @@ static void draw_calendar_grid() {
             } else if (current_day <= days_in_current_month) {
                 // Format day number
                 char day_str[4];
-                if (current_day < 10) {
-                    day_str[0] = ' ';
-                    day_str[1] = '0' + current_day;
-                    day_str[2] = '\0';
-                } else {
-                    int_to_string(current_day, day_str);
-                }
+                snprintf(day_str, sizeof(day_str), "%2d", current_day);
 
                 // Determine color based on day type
                 uint8_t day_color;
@@ -240,21 +192,7 @@ static void draw_sidebar() {
     // Current date info
     vga_put_string(2, 6, "Today:", sidebar_color);
     char today_str[15];
-    char day_str[4];
-    int_to_string(current_date.day, day_str);
-    int pos = 0;
-
-    // Build today string
-    for (int i = 0; day_str[i] && pos < 10; i++) {
-        today_str[pos++] = day_str[i];
-    }
-    today_str[pos++] = '/';
-    char month_str[4];
-    int_to_string(current_date.month, month_str);
-    for (int i = 0; month_str[i] && pos < 14; i++) {
-        today_str[pos++] = month_str[i];
-    }
-    today_str[pos] = '\0';
+    snprintf(today_str, sizeof(today_str), "%d/%d", current_date.day, current_date.month);
 
     vga_put_string(2, 7, today_str, MAKE_COLOR(COLOR_WHITE, COLOR_BLACK));
 
@@ -262,7 +200,7 @@ static void draw_sidebar() {
     vga_put_string(2, 9, "Selected:", sidebar_color);
     Event* selected_event = find_event(selected_day, view_date.month, view_date.year);
     char selected_str[4];
-    int_to_string(selected_day, selected_str);
+    snprintf(selected_str, sizeof(selected_str), "%d", selected_day);
     vga_put_string(2, 10, selected_str, MAKE_COLOR(COLOR_WHITE, COLOR_BLACK));
 
     if (selected_event) {
@@ -274,22 +212,9 @@ static void draw_sidebar() {
     int event_line = 15;
     for (unsigned int i = 0; i < NUM_EVENTS && event_line < 22; i++) {
         if (events[i].month == view_date.month && events[i].year == view_date.year) {
+            // Day and the first few chars of the title
             char event_str[12];
-            char event_day_str[12];
-            int_to_string(events[i].day, event_day_str);
-
-            int pos = 0;
-            for (int j = 0; event_day_str[j] && pos < 3; j++) {
-                event_str[pos++] = event_day_str[j];
-            }
-            event_str[pos++] = ':';
-            event_str[pos++] = ' ';
-
-            // Add first few chars of title
-            for (int j = 0; events[i].title[j] && pos < 11; j++) {
-                event_str[pos++] = events[i].title[j];
-            }
-            event_str[pos] = '\0';
+            snprintf(event_str, sizeof(event_str), "%d: %s", events[i].day, events[i].title);
 
             vga_put_string(2, event_line, event_str, MAKE_COLOR(events[i].color, COLOR_BLACK));
             event_line++;
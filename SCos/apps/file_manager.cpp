@@ -3,13 +3,6 @@
 #include "../ui/window_manager.hpp"
 #include <stdint.h>
 
-// Local string function implementations for freestanding environment
-static int fm_strlen(const char* str) {
-    int len = 0;
-    while (str[len]) len++;
-    return len;
-}
-
 void openFileManager() {
     uint8_t header_color = MAKE_COLOR(COLOR_WHITE, COLOR_BLUE);
     uint8_t text_color = MAKE_COLOR(COLOR_BLACK, COLOR_WHITE);
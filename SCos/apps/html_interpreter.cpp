@@ -1,7 +1,10 @@
 
 #include "html_interpreter.hpp"
 #include "../ui/window_manager.hpp"
+#include "../drivers/timer.hpp"
 #include "../include/string.h"
+#include "../include/kstring.hpp"
+#include "../memory/arena.hpp"
 
 static HTMLElement dom_elements[MAX_DOM_ELEMENTS];
 static CSSRule css_rules[MAX_CSS_RULES];
@@ -9,91 +12,21 @@ static JSFunction js_functions[MAX_JS_FUNCTIONS];
 static int element_count = 0;
 static int css_rule_count = 0;
 static int js_function_count = 0;
+// Scratch space for tag and text copies; released when each parse returns
+static arena parse_arena;
 
-// Enhanced string utility functions
-static int html_strlen(const char* str) {
-    int len = 0;
-    while (str[len]) len++;
-    return len;
-}
-
-static void html_strcpy(char* dest, const char* src) {
-    while (*src) {
-        *dest++ = *src++;
-    }
-    *dest = '\0';
-}
-
-static int html_strcmp(const char* str1, const char* str2) {
-    while (*str1 && (*str1 == *str2)) {
-        str1++;
-        str2++;
-    }
-    return *(unsigned char*)str1 - *(unsigned char*)str2;
-}
-
-static bool html_strstr(const char* haystack, const char* needle) {
-    if (!*needle) return true;
-    for (; *haystack; haystack++) {
-        const char* h = haystack;
-        const char* n = needle;
-        while (*h && *n && *h == *n) {
-            h++;
-            n++;
-        }
-        if (!*n) return true;
-    }
-    return false;
-}
-
-static void html_strcat(char* dest, const char* src) {
-    dest += html_strlen(dest);
-    html_strcpy(dest, src);
-}
-
+// Trims whitespace in place; the move is towards the start, so copying
+// forwards is safe even though the ranges overlap
 static void html_trim(char* str) {
-    // Remove leading whitespace
-    char* start = str;
-    while (*start && (*start == ' ' || *start == '\t' || *start == '\n' || *start == '\r')) {
-        start++;
-    }
-    
-    // Move string to beginning
-    char* write = str;
-    while (*start) {
-        *write++ = *start++;
+    StrView trimmed = StrView(str).trim();
+    for (size_t i = 0; i < trimmed.length; i++) {
+        str[i] = trimmed.data[i];
     }
-    *write = '\0';
-    
-    // Remove trailing whitespace
-    if (write > str) {
-        write--;
-        while (write >= str && (*write == ' ' || *write == '\t' || *write == '\n' || *write == '\r')) {
-            *write-- = '\0';
-        }
-    }
-}
-
-static int html_atoi(const char* str) {
-    int result = 0;
-    int sign = 1;
-    
-    if (*str == '-') {
-        sign = -1;
-        str++;
-    } else if (*str == '+') {
-        str++;
-    }
-    
-    while (*str >= '0' && *str <= '9') {
-        result = result * 10 + (*str - '0');
-        str++;
-    }
-    
-    return sign * result;
+    str[trimmed.length] = '\0';
 }
 
 void HTMLInterpreter::init() {
+    arena_init(&parse_arena);
     reset();
 }
 
@@ -137,6 +70,7 @@ bool HTMLInterpreter::parseHTML(const char* html_content) {
     int current_parent = -1;
     int tag_stack[50];  // Stack to track nested elements
     int stack_depth = 0;
+    arena_scope parse_scope(&parse_arena);
 
     while (*pos && element_count < MAX_DOM_ELEMENTS) {
         if (*pos == '<') {
@@ -145,14 +79,10 @@ bool HTMLInterpreter::parseHTML(const char* html_content) {
             if (!*tag_end) break;
 
             // Extract tag content
-            char tag_content[512];
+            arena_scope tag_scope(&parse_arena);
             int tag_len = tag_end - pos - 1;
-            if (tag_len > 511) tag_len = 511;
-
-            for (int i = 0; i < tag_len; i++) {
-                tag_content[i] = pos[i + 1];
-            }
-            tag_content[tag_len] = '\0';
+            char* tag_content = arena_strndup(&parse_arena, pos + 1, tag_len);
+            if (!tag_content) break;
 
             html_trim(tag_content);
 
@@ -195,19 +125,13 @@ bool HTMLInterpreter::parseHTML(const char* html_content) {
             while (*pos && *pos != '<') pos++;
             
             if (pos > text_start && current_parent >= 0) {
-                // Add text content to current parent
-                char text_content[256];
-                int text_len = pos - text_start;
-                if (text_len > 255) text_len = 255;
-                
-                for (int i = 0; i < text_len; i++) {
-                    text_content[i] = text_start[i];
-                }
-                text_content[text_len] = '\0';
-                
-                html_trim(text_content);
-                if (text_content[0] != '\0') {
-                    html_strcat(dom_elements[current_parent].content, text_content);
+                // Add text content to current parent. The run is trimmed in
+                // place and only the part that fits the remaining space in
+                // content is copied, however long the text node is.
+                StrView text = StrView(text_start, pos - text_start).trim();
+                if (text.length) {
+                    char* content = dom_elements[current_parent].content;
+                    str_append(content, sizeof(dom_elements[current_parent].content), strlen(content), text);
                 }
             }
             
@@ -240,7 +164,7 @@ bool HTMLInterpreter::isVoidElement(const char* tag_name) {
     };
     
     for (int i = 0; i < 14; i++) {
-        if (html_strcmp(tag_name, void_elements[i]) == 0) {
+        if (strcmp(tag_name, void_elements[i]) == 0) {
             return true;
         }
     }
@@ -285,43 +209,43 @@ int HTMLInterpreter::parseHTMLElement(const char* element_text, int parent_id) {
 }
 
 void HTMLInterpreter::setDefaultElementProperties(HTMLElement* element) {
-    if (html_strcmp(element->tag, "h1") == 0) {
+    if (strcmp(element->tag, "h1") == 0) {
         element->width = 60;
         element->height = 2;
         element->color = 0x4F; // Red
-    } else if (html_strcmp(element->tag, "h2") == 0) {
+    } else if (strcmp(element->tag, "h2") == 0) {
         element->width = 55;
         element->height = 2;
         element->color = 0x2F; // Green
-    } else if (html_strcmp(element->tag, "h3") == 0) {
+    } else if (strcmp(element->tag, "h3") == 0) {
         element->width = 50;
         element->height = 1;
         element->color = 0x6F; // Yellow
-    } else if (html_strcmp(element->tag, "p") == 0) {
+    } else if (strcmp(element->tag, "p") == 0) {
         element->width = 70;
         element->height = 1;
         element->color = 0x1F; // White
-    } else if (html_strcmp(element->tag, "button") == 0) {
+    } else if (strcmp(element->tag, "button") == 0) {
         element->width = 15;
         element->height = 1;
         element->color = 0x70; // Black on gray
-    } else if (html_strcmp(element->tag, "input") == 0) {
+    } else if (strcmp(element->tag, "input") == 0) {
         element->width = 20;
         element->height = 1;
         element->color = 0x0F; // White on black
-    } else if (html_strcmp(element->tag, "div") == 0) {
+    } else if (strcmp(element->tag, "div") == 0) {
         element->width = 75;
         element->height = 1;
         element->color = 0x1F; // White on blue
-    } else if (html_strcmp(element->tag, "span") == 0) {
+    } else if (strcmp(element->tag, "span") == 0) {
         element->width = 20;
         element->height = 1;
         element->color = 0x1F; // White on blue
-    } else if (html_strcmp(element->tag, "ul") == 0 || html_strcmp(element->tag, "ol") == 0) {
+    } else if (strcmp(element->tag, "ul") == 0 || strcmp(element->tag, "ol") == 0) {
         element->width = 70;
         element->height = 1;
         element->color = 0x1F; // White on blue
-    } else if (html_strcmp(element->tag, "li") == 0) {
+    } else if (strcmp(element->tag, "li") == 0) {
         element->width = 68;
         element->height = 1;
         element->color = 0x1F; // White on blue
@@ -389,16 +313,16 @@ void HTMLInterpreter::parseAttributes(const char* attrs, HTMLElement* element) {
         if (quote_char && *pos) pos++; // Skip closing quote
 
         // Process specific attributes
-        if (html_strcmp(attr_name, "id") == 0) {
-            html_strcpy(element->id, attr_value);
-        } else if (html_strcmp(attr_name, "class") == 0) {
-            html_strcpy(element->class_name, attr_value);
-        } else if (html_strcmp(attr_name, "style") == 0) {
+        if (strcmp(attr_name, "id") == 0) {
+            str_copy(element->id, sizeof(element->id), attr_value);
+        } else if (strcmp(attr_name, "class") == 0) {
+            str_copy(element->class_name, sizeof(element->class_name), attr_value);
+        } else if (strcmp(attr_name, "style") == 0) {
             parseInlineStyle(attr_value, element);
-        } else if (html_strcmp(attr_name, "width") == 0) {
-            element->width = html_atoi(attr_value);
-        } else if (html_strcmp(attr_name, "height") == 0) {
-            element->height = html_atoi(attr_value);
+        } else if (strcmp(attr_name, "width") == 0) {
+            element->width = str_to_int(attr_value);
+        } else if (strcmp(attr_name, "height") == 0) {
+            element->height = str_to_int(attr_value);
         }
     }
 }
@@ -451,14 +375,14 @@ void HTMLInterpreter::parseInlineStyle(const char* style, HTMLElement* element)
 }
 
 void HTMLInterpreter::applyCSSProperty(HTMLElement* element, const char* property, const char* value) {
-    if (html_strcmp(property, "color") == 0) {
+    if (strcmp(property, "color") == 0) {
         element->color = (element->color & 0xF0) | (parseColor(value) & 0x0F);
-    } else if (html_strcmp(property, "background-color") == 0) {
+    } else if (strcmp(property, "background-color") == 0) {
         element->color = (element->color & 0x0F) | ((parseColor(value) & 0x0F) << 4);
-    } else if (html_strcmp(property, "width") == 0) {
-        element->width = html_atoi(value);
-    } else if (html_strcmp(property, "height") == 0) {
-        element->height = html_atoi(value);
+    } else if (strcmp(property, "width") == 0) {
+        element->width = str_to_int(value);
+    } else if (strcmp(property, "height") == 0) {
+        element->height = str_to_int(value);
     }
 }
 
@@ -543,7 +467,7 @@ bool HTMLInterpreter::parseCSS(const char* css_content) {
             // Prepare next rule with same selector
             if (css_rule_count < MAX_CSS_RULES) {
                 rule = &css_rules[css_rule_count];
-                html_strcpy(rule->selector, css_rules[css_rule_count-1].selector);
+                str_copy(rule->selector, sizeof(rule->selector), css_rules[css_rule_count-1].selector);
             }
         }
 
@@ -577,7 +501,7 @@ bool HTMLInterpreter::parseJS(const char* js_content) {
         }
 
         // Look for function keyword
-        if (html_strstr(pos, "function")) {
+        if (strncmp(pos, "function", 8) == 0) {
             pos += 8; // Skip "function"
             while (*pos && (*pos == ' ' || *pos == '\t')) pos++;
 
@@ -645,34 +569,30 @@ void HTMLInterpreter::applyCSSRules() {
 bool HTMLInterpreter::matchesSelector(HTMLElement* element, const char* selector) {
     if (selector[0] == '#') {
         // ID selector
-        return html_strcmp(selector + 1, element->id) == 0;
+        return strcmp(selector + 1, element->id) == 0;
     } else if (selector[0] == '.') {
         // Class selector
-        return html_strstr(element->class_name, selector + 1);
+        return StrView(element->class_name).contains(selector + 1);
     } else {
-        // Tag selector or compound selector
-        char tag_selector[64];
-        html_strcpy(tag_selector, selector);
-        
-        // Handle compound selectors (space-separated)
-        char* space = tag_selector;
-        while (*space && *space != ' ') space++;
-        if (*space) *space = '\0';
+        // Tag selector, or the first part of a compound (space-separated) one
+        StrView tag_selector(selector);
+        int space = tag_selector.find(' ');
+        if (space >= 0) tag_selector = tag_selector.substr(0, space);
         
-        return html_strcmp(tag_selector, element->tag) == 0;
+        return tag_selector.equals(element->tag);
     }
 }
 
 uint8_t HTMLInterpreter::parseColor(const char* color_name) {
-    if (html_strcmp(color_name, "red") == 0) return 4;
-    if (html_strcmp(color_name, "green") == 0) return 2;
-    if (html_strcmp(color_name, "blue") == 0) return 1;
-    if (html_strcmp(color_name, "yellow") == 0) return 6;
-    if (html_strcmp(color_name, "cyan") == 0) return 3;
-    if (html_strcmp(color_name, "magenta") == 0) return 5;
-    if (html_strcmp(color_name, "white") == 0) return 15;
-    if (html_strcmp(color_name, "black") == 0) return 0;
-    if (html_strcmp(color_name, "gray") == 0 || html_strcmp(color_name, "grey") == 0) return 8;
+    if (strcmp(color_name, "red") == 0) return 4;
+    if (strcmp(color_name, "green") == 0) return 2;
+    if (strcmp(color_name, "blue") == 0) return 1;
+    if (strcmp(color_name, "yellow") == 0) return 6;
+    if (strcmp(color_name, "cyan") == 0) return 3;
+    if (strcmp(color_name, "magenta") == 0) return 5;
+    if (strcmp(color_name, "white") == 0) return 15;
+    if (strcmp(color_name, "black") == 0) return 0;
+    if (strcmp(color_name, "gray") == 0 || strcmp(color_name, "grey") == 0) return 8;
     
     // Handle hex colors (#RGB or #RRGGBB)
     if (color_name[0] == '#') {
@@ -698,7 +618,7 @@ void HTMLInterpreter::calculateLayout() {
             // Child elements - position relative to parent
             HTMLElement* parent = &dom_elements[element->parent_id];
             
-            if (html_strcmp(element->tag, "li") == 0) {
+            if (strcmp(element->tag, "li") == 0) {
                 // List items get indented
                 element->x = parent->x + 4;
                 element->y = parent->y + parent->height + (element - dom_elements - element->parent_id - 1);
@@ -720,12 +640,12 @@ void HTMLInterpreter::calculateLayout() {
 }
 
 int HTMLInterpreter::getElementSpacing(HTMLElement* element) {
-    if (html_strcmp(element->tag, "h1") == 0) return 2;
-    if (html_strcmp(element->tag, "h2") == 0) return 1;
-    if (html_strcmp(element->tag, "h3") == 0) return 1;
-    if (html_strcmp(element->tag, "p") == 0) return 1;
-    if (html_strcmp(element->tag, "div") == 0) return 1;
-    if (html_strcmp(element->tag, "ul") == 0 || html_strcmp(element->tag, "ol") == 0) return 1;
+    if (strcmp(element->tag, "h1") == 0) return 2;
+    if (strcmp(element->tag, "h2") == 0) return 1;
+    if (strcmp(element->tag, "h3") == 0) return 1;
+    if (strcmp(element->tag, "p") == 0) return 1;
+    if (strcmp(element->tag, "div") == 0) return 1;
+    if (strcmp(element->tag, "ul") == 0 || strcmp(element->tag, "ol") == 0) return 1;
     return 0;
 }
 
@@ -753,10 +673,10 @@ void HTMLInterpreter::renderElement(HTMLElement* element, int window_id) {
     
     // Special rendering for certain elements
     char prefix[8] = "";
-    if (html_strcmp(element->tag, "li") == 0) {
-        html_strcpy(prefix, "• ");
-    } else if (html_strcmp(element->tag, "button") == 0) {
-        html_strcpy(prefix, "[");
+    if (strcmp(element->tag, "li") == 0) {
+        str_copy(prefix, sizeof(prefix), "• ");
+    } else if (strcmp(element->tag, "button") == 0) {
+        str_copy(prefix, sizeof(prefix), "[");
     }
 
     // Render prefix
@@ -784,7 +704,7 @@ void HTMLInterpreter::renderElement(HTMLElement* element, int window_id) {
     }
 
     // Add suffix for buttons
-    if (html_strcmp(element->tag, "button") == 0 && x_offset < element->width) {
+    if (strcmp(element->tag, "button") == 0 && x_offset < element->width) {
         if (screen_x + x_offset >= 0 && screen_x + x_offset < 80 && 
             screen_y >= 0 && screen_y < 25) {
             int idx = 2 * (screen_y * 80 + screen_x + x_offset);
@@ -803,13 +723,13 @@ void HTMLInterpreter::handleClick(int x, int y) {
             y >= element->y && y < element->y + element->height) {
 
             // Look for onclick handler
-            if (html_strcmp(element->tag, "button") == 0) {
+            if (strcmp(element->tag, "button") == 0) {
                 char onclick_func[128];
                 if (element->id[0] != '\0') {
-                    html_strcpy(onclick_func, element->id);
-                    html_strcat(onclick_func, "_click");
+                    size_t length = str_copy(onclick_func, sizeof(onclick_func), element->id);
+                    str_append(onclick_func, sizeof(onclick_func), length, "_click");
                 } else {
-                    html_strcpy(onclick_func, "button_click");
+                    str_copy(onclick_func, sizeof(onclick_func), "button_click");
                 }
                 executeJS(onclick_func);
             }
@@ -820,12 +740,12 @@ void HTMLInterpreter::handleClick(int x, int y) {
 
 void HTMLInterpreter::executeJS(const char* function_name) {
     for (int i = 0; i < js_function_count; i++) {
-        if (js_functions[i].active && html_strcmp(js_functions[i].name, function_name) == 0) {
+        if (js_functions[i].active && strcmp(js_functions[i].name, function_name) == 0) {
             // Simple JS execution - this is a basic implementation
             // In a full implementation, this would parse and execute the JS
             
             // For now, we can handle some basic functions
-            if (html_strstr(js_functions[i].body, "alert")) {
+            if (StrView(js_functions[i].body).contains("alert")) {
                 // Simple alert simulation - could flash the screen or show a message
                 flashScreen();
             }
@@ -848,8 +768,7 @@ void HTMLInterpreter::flashScreen() {
         video[i * 2 + 1] = 0xFF;
     }
     
-    // Simple delay
-    for (volatile int i = 0; i < 1000000; i++);
+    ksleep_ms(50);
     
     // Restore colors
     for (int i = 0; i < 80 * 25; i++) {
@@ -859,7 +778,7 @@ void HTMLInterpreter::flashScreen() {
 
 int HTMLInterpreter::findElementById(const char* id) {
     for (int i = 0; i < element_count; i++) {
-        if (html_strcmp(dom_elements[i].id, id) == 0) {
+        if (strcmp(dom_elements[i].id, id) == 0) {
             return i;
         }
     }
@@ -868,7 +787,7 @@ int HTMLInterpreter::findElementById(const char* id) {
 
 int HTMLInterpreter::findElementByTag(const char* tag) {
     for (int i = 0; i < element_count; i++) {
-        if (html_strcmp(dom_elements[i].tag, tag) == 0) {
+        if (strcmp(dom_elements[i].tag, tag) == 0) {
             return i;
         }
     }
@@ -883,7 +802,7 @@ HTMLElement* HTMLInterpreter::getElementById(const char* id) {
 void HTMLInterpreter::updateElementContent(const char* id, const char* new_content) {
     HTMLElement* element = getElementById(id);
     if (element) {
-        html_strcpy(element->content, new_content);
+        str_copy(element->content, sizeof(element->content), new_content);
     }
 }
 
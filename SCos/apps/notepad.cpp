@@ -1,39 +1,11 @@
 #include "notepad.hpp"
 #include "../ui/window_manager.hpp"
 #include <stdint.h>
+#include "../include/kstring.hpp"
 
 // Include VGA utils header
 #include "../ui/vga_utils.hpp"
 
-// Local string function implementations for freestanding environment
-static int calc_strlen(const char* str) {
-    int len = 0;
-    while (str[len]) len++;
-    return len;
-}
-
-static void calc_strcpy(char* dest, const char* src) {
-    while (*src) {
-        *dest++ = *src++;
-    }
-    *dest = '\0';
-}
-
-static void calc_strcat(char* dest, const char* src) {
-    while (*dest) dest++;
-    while (*src) {
-        *dest++ = *src++;
-    }
-    *dest = '\0';
-}
-
-static void calc_memset(void* ptr, int value, int size) {
-    char* p = (char*)ptr;
-    for (int i = 0; i < size; i++) {
-        p[i] = value;
-    }
-}
-
 // Notepad state
 static char notepad_buffer[MAX_NOTEPAD_LINES * MAX_NOTEPAD_LINE_LENGTH];
 static int cursor_x = 0;
@@ -44,7 +16,7 @@ static int current_line = 0;
 static int current_col = 0;
 
 void Notepad::init() {
-    calc_memset(notepad_buffer, 0, sizeof(notepad_buffer));
+    memset(notepad_buffer, 0, sizeof(notepad_buffer));
     cursor_x = 0;
     cursor_y = 0;
     notepad_window_id = -1;
@@ -242,11 +214,8 @@ void Notepad::updateDisplay() {
 // Legacy function support for compatibility
 void openNotepad(const char* initial_content) {
     Notepad::init();
-    if (initial_content && calc_strlen(initial_content) > 0) {
-        // Copy initial content to buffer
-        for (int i = 0; i < calc_strlen(initial_content) && i < sizeof(notepad_buffer) - 1; i++) {
-            notepad_buffer[i] = initial_content[i];
-        }
+    if (initial_content) {
+        str_copy(notepad_buffer, sizeof(notepad_buffer), initial_content);
     }
     Notepad::show();
 }
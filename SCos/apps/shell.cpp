@@ -7,14 +7,24 @@
 Shell::Shell() {
     current_directory[0] = '/';
     current_directory[1] = '\0';
+    arena_init(&scratch, 1024);
+}
+
+Shell::~Shell() {
+    arena_release(&scratch);
 }
 
 bool Shell::execute_command(const char* cmd, char* output, size_t output_size) {
     if (strlen(cmd) == 0) return true;
     
-    char command[256];
-    char args[256];
-    parse_command(cmd, command, args);
+    arena_scope scope(&scratch);
+    char* command;
+    char* args;
+    parse_command(cmd, &command, &args);
+    if (!command || !args) {
+        snprintf(output, output_size, "Out of memory");
+        return false;
+    }
     
     if (strcmp(command, "ls") == 0) {
         return cmd_ls(args, output, output_size);
@@ -52,35 +62,21 @@ bool Shell::execute_command(const char* cmd, char* output, size_t output_size) {
     }
 }
 
-void Shell::parse_command(const char* input, char* command, char* args) {
+void Shell::parse_command(const char* input, char** command, char** args) {
     int i = 0;
-    while (input[i] && input[i] != ' ') {
-        command[i] = input[i];
-        i++;
-    }
-    command[i] = '\0';
+    while (input[i] && input[i] != ' ') i++;
+    *command = arena_strndup(&scratch, input, i);
     
     while (input[i] == ' ') i++;
     
-    int j = 0;
-    while (input[i]) {
-        args[j++] = input[i++];
-    }
-    args[j] = '\0';
+    *args = arena_strndup(&scratch, input + i, strlen(input + i));
 }
 
-bool Shell::cmd_ls(const char* args, char* output, size_t) {
+bool Shell::cmd_ls(const char* args, char* output, size_t output_size) {
     const char* path = (strlen(args) > 0) ? args : current_directory;
     
     // Simple file listing implementation
-    strcpy(output, "Files in ");
-    strcat(output, path);
-    strcat(output, ":\n");
-    strcat(output, "..\n");
-    strcat(output, "documents/\n");
-    strcat(output, "system/\n");
-    strcat(output, "temp/\n");
-    strcat(output, "readme.txt\n");
+    snprintf(output, output_size, "Files in %s:\n..\ndocuments/\nsystem/\ntemp/\nreadme.txt\n", path);
     
     return true;
 }
@@ -88,7 +84,7 @@ bool Shell::cmd_ls(const char* args, char* output, size_t) {
 bool Shell::cmd_cd(const char* args, char* output, size_t output_size) {
     if (strlen(args) == 0) {
         strcpy(current_directory, "/");
-        strcpy(output, "Changed to root directory");
+        snprintf(output, output_size, "Changed to root directory");
         return true;
     }
     
@@ -105,7 +101,12 @@ bool Shell::cmd_cd(const char* args, char* output, size_t output_size) {
         return true;
     }
     
-    char new_path[512];
+    size_t path_length = strlen(current_directory) + strlen(args) + 2;
+    char* new_path = (char*)arena_alloc(&scratch, path_length, 1);
+    if (!new_path || path_length > SHELL_PATH_MAX) {
+        snprintf(output, output_size, "Path too long: %s", args);
+        return false;
+    }
     if (args[0] == '/') {
         strcpy(new_path, args);
     } else {
@@ -128,7 +129,7 @@ bool Shell::cmd_pwd(char* output, size_t output_size) {
 
 bool Shell::cmd_mkdir(const char* args, char* output, size_t output_size) {
     if (strlen(args) == 0) {
-        strcpy(output, "Usage: mkdir <directory>");
+        snprintf(output, output_size, "Usage: mkdir <directory>");
         return false;
     }
     
@@ -138,7 +139,7 @@ bool Shell::cmd_mkdir(const char* args, char* output, size_t output_size) {
 
 bool Shell::cmd_touch(const char* args, char* output, size_t output_size) {
     if (strlen(args) == 0) {
-        strcpy(output, "Usage: touch <filename>");
+        snprintf(output, output_size, "Usage: touch <filename>");
         return false;
     }
     
@@ -148,14 +149,14 @@ bool Shell::cmd_touch(const char* args, char* output, size_t output_size) {
 
 bool Shell::cmd_cat(const char* args, char* output, size_t output_size) {
     if (strlen(args) == 0) {
-        strcpy(output, "Usage: cat <filename>");
+        snprintf(output, output_size, "Usage: cat <filename>");
         return false;
     }
     
     if (strcmp(args, "readme.txt") == 0) {
-        strcpy(output, "Welcome to SCos!\n");
-        strcat(output, "This is a simple operating system.\n");
-        strcat(output, "Type 'help' for available commands.");
+        snprintf(output, output_size, "%s", "Welcome to SCos!\n"
+                 "This is a simple operating system.\n"
+                 "Type 'help' for available commands.");
     } else {
         snprintf(output, output_size, "File not found: %s", args);
         return false;
@@ -166,7 +167,7 @@ bool Shell::cmd_cat(const char* args, char* output, size_t output_size) {
 
 bool Shell::cmd_rm(const char* args, char* output, size_t output_size) {
     if (strlen(args) == 0) {
-        strcpy(output, "Usage: rm <filename>");
+        snprintf(output, output_size, "Usage: rm <filename>");
         return false;
     }
     
@@ -175,9 +176,10 @@ bool Shell::cmd_rm(const char* args, char* output, size_t output_size) {
 }
 
 bool Shell::cmd_cp(const char* args, char* output, size_t output_size) {
-    char src[256], dst[256];
-    if (sscanf(args, "%s %s", src, dst) != 2) {
-        strcpy(output, "Usage: cp <source> <destination>");
+    char* src = (char*)arena_alloc(&scratch, strlen(args) + 1, 1);
+    char* dst = (char*)arena_alloc(&scratch, strlen(args) + 1, 1);
+    if (!src || !dst || sscanf(args, "%s %s", src, dst) != 2) {
+        snprintf(output, output_size, "Usage: cp <source> <destination>");
         return false;
     }
     
@@ -186,9 +188,10 @@ bool Shell::cmd_cp(const char* args, char* output, size_t output_size) {
 }
 
 bool Shell::cmd_mv(const char* args, char* output, size_t output_size) {
-    char src[256], dst[256];
-    if (sscanf(args, "%s %s", src, dst) != 2) {
-        strcpy(output, "Usage: mv <source> <destination>");
+    char* src = (char*)arena_alloc(&scratch, strlen(args) + 1, 1);
+    char* dst = (char*)arena_alloc(&scratch, strlen(args) + 1, 1);
+    if (!src || !dst || sscanf(args, "%s %s", src, dst) != 2) {
+        snprintf(output, output_size, "Usage: mv <source> <destination>");
         return false;
     }
     
@@ -198,7 +201,7 @@ bool Shell::cmd_mv(const char* args, char* output, size_t output_size) {
 
 bool Shell::cmd_find(const char* args, char* output, size_t output_size) {
     if (strlen(args) == 0) {
-        strcpy(output, "Usage: find <pattern>");
+        snprintf(output, output_size, "Usage: find <pattern>");
         return false;
     }
     
@@ -210,50 +213,6 @@ const char* Shell::get_current_directory() const {
     return current_directory;
 }
 
-int snprintf(char* str, size_t size, const char* format, ...) {
-    va_list args;
-    va_start(args, format);
-    
-    size_t pos = 0;
-    while (*format && pos < size - 1) {
-        if (*format == '%') {
-            format++;
-            if (*format == 's') {
-                const char* s = va_arg(args, const char*);
-                while (*s && pos < size - 1) {
-                    str[pos++] = *s++;
-                }
-            } else if (*format == 'd') {
-                int d = va_arg(args, int);
-                char num[32];
-                int i = 0;
-                if (d == 0) {
-                    num[i++] = '0';
-                } else {
-                    if (d < 0) {
-                        str[pos++] = '-';
-                        d = -d;
-                    }
-                    while (d > 0) {
-                        num[i++] = '0' + (d % 10);
-                        d /= 10;
-                    }
-                    for (int j = i - 1; j >= 0 && pos < size - 1; j--) {
-                        str[pos++] = num[j];
-                    }
-                }
-            }
-        } else {
-            str[pos++] = *format;
-        }
-        format++;
-    }
-    str[pos] = '\0';
-    
-    va_end(args);
-    return pos;
-}
-
 int sscanf(const char* str, const char* format, ...) {
     va_list args;
     va_start(args, format);
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "../include/stddef.h"
+#include "../include/stdarg.h"
+#include "../memory/arena.hpp"
+
+#define SHELL_PATH_MAX 256
+
+class Shell {
+public:
+    Shell();
+    ~Shell();
+    bool execute_command(const char* cmd, char* output, size_t output_size);
+    const char* get_current_directory() const;
+
+private:
+    void parse_command(const char* input, char** command, char** args);
+    bool cmd_ls(const char* args, char* output, size_t output_size);
+    bool cmd_cd(const char* args, char* output, size_t output_size);
+    bool cmd_pwd(char* output, size_t output_size);
+    bool cmd_mkdir(const char* args, char* output, size_t output_size);
+    bool cmd_touch(const char* args, char* output, size_t output_size);
+    bool cmd_cat(const char* args, char* output, size_t output_size);
+    bool cmd_rm(const char* args, char* output, size_t output_size);
+    bool cmd_cp(const char* args, char* output, size_t output_size);
+    bool cmd_mv(const char* args, char* output, size_t output_size);
+    bool cmd_find(const char* args, char* output, size_t output_size);
+
+    char current_directory[SHELL_PATH_MAX];
+    // Scratch memory for one command; rolled back when it returns
+    arena scratch;
+};
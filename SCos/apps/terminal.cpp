@@ -1,47 +1,43 @@
 #include "terminal.hpp"
 #include "../ui/window_manager.hpp"
+#include "../memory/heap_profile.hpp"
+#include "../debug/trace.hpp"
+#include "../interrupt/irq.hpp"
+#include "../drivers/timer.hpp"
+#include "../kernel/thread.hpp"
+#include "../kernel/fiber.hpp"
+#include "../kernel/smp.hpp"
+#include "../kernel/lock_stats.hpp"
+#include "../include/string.h"
+#include "../include/kstring.hpp"
 #include <stdint.h>
 
 // Forward declarations
-void drawTerminalContent();
 void executeCommand();
-void handleTerminalInput(uint8_t key);
-
-// Local string function implementations for freestanding environment
-static int terminal_strlen(const char* str) {
-    int len = 0;
-    while (str[len]) len++;
-    return len;
-}
-
-static void terminal_strcpy(char* dest, const char* src) {
-    while (*src) {
-        *dest++ = *src++;
-    }
-    *dest = '\0';
-}
-
-static void terminal_strcat(char* dest, const char* src) {
-    while (*dest) dest++;
-    while (*src) {
-        *dest++ = *src++;
-    }
-    *dest = '\0';
-}
 
 // Terminal state
-static char terminal_buffer[2048];
+#define TERMINAL_BUFFER_SIZE 2048
+static char terminal_buffer[TERMINAL_BUFFER_SIZE];
+static size_t terminal_length = 0;
 static char current_line[256];
 static int terminal_window_id = -1;
 static bool terminal_visible = false;
 static int cursor_pos = 0;
 
+static void terminal_set(StrView text) {
+    terminal_length = str_copy(terminal_buffer, sizeof(terminal_buffer), text);
+}
+
+static void terminal_append(StrView text) {
+    terminal_length = str_append(terminal_buffer, sizeof(terminal_buffer), terminal_length, text);
+}
+
 void runTerminal() {
     if (terminal_visible) return;
 
     // Initialize terminal
-    terminal_strcpy(terminal_buffer, "SCos Terminal v1.0\n> ");
-    terminal_strcpy(current_line, "");
+    terminal_set("SCos Terminal v1.0\n> ");
+    current_line[0] = '\0';
     cursor_pos = 0;
 
     // Create terminal window
@@ -65,6 +61,10 @@ bool isTerminalVisible() {
     return terminal_visible;
 }
 
+bool terminalHasFocus() {
+    return terminal_visible && WindowManager::getActiveWindow() == terminal_window_id;
+}
+
 void drawTerminalContent() {
     if (!terminal_visible || terminal_window_id < 0) return;
 
@@ -84,10 +84,22 @@ void drawTerminalContent() {
         }
     }
 
+    // Skip the oldest lines so the prompt stays on screen
+    int rows = win->height - 3;
+    if (rows < 1) rows = 1;
+    int lines = 1;
+    for (size_t i = 0; i < terminal_length; ++i) {
+        if (terminal_buffer[i] == '\n') lines++;
+    }
+    size_t start = 0;
+    for (int skip = lines - rows; skip > 0 && start < terminal_length; ++start) {
+        if (terminal_buffer[start] == '\n') skip--;
+    }
+
     // Draw terminal buffer
     int line = 0;
     int col = 0;
-    for (int i = 0; terminal_buffer[i] && line < win->height - 3; ++i) {
+    for (size_t i = start; terminal_buffer[i] && line < rows; ++i) {
         if (terminal_buffer[i] == '\n') {
             line++;
             col = 0;
@@ -115,28 +127,25 @@ void drawTerminalContent() {
     }
 }
 
-void handleTerminalInput(uint8_t key) {
+void handleTerminalInput(char key) {
     if (!terminal_visible) return;
 
     switch (key) {
-        case 0x01: // Escape
+        case 27: // Escape
             closeTerminal();
             break;
-        case 0x0E: // Backspace
+        case '\b':
             if (cursor_pos > 0) {
                 current_line[--cursor_pos] = '\0';
                 drawTerminalContent();
             }
             break;
-        case 0x1C: // Enter
+        case '\n':
             executeCommand();
             break;
         default:
-            // Handle printable characters (simplified)
-            if (key >= 0x02 && key <= 0x0D && cursor_pos < 255) { // Number keys
-                char c = '0' + (key - 1);
-                if (key == 0x0B) c = '0';
-                current_line[cursor_pos++] = c;
+            if (key >= ' ' && key <= '~' && cursor_pos < 255) {
+                current_line[cursor_pos++] = key;
                 current_line[cursor_pos] = '\0';
                 drawTerminalContent();
             }
@@ -144,33 +153,107 @@ void handleTerminalInput(uint8_t key) {
     }
 }
 
+// Shows the heap profile summary and the biggest owners of live memory;
+// the full report goes to the serial port
+static void showHeapProfile() {
+    heap_profile_summary summary;
+    heap_profile_get_summary(&summary);
+    heap_profile_dump();
+
+    char line[64];
+    snprintf(line, sizeof(line), "Live %d KB in %d allocs, peak %d KB\n",
+             summary.live_bytes / 1024, summary.live_count, summary.peak_bytes / 1024);
+    terminal_append(line);
+    snprintf(line, sizeof(line), "Free %d KB, largest block %d KB\n",
+             summary.free_bytes / 1024, summary.largest_free / 1024);
+    terminal_append(line);
+
+    heap_profile_site top[3];
+    int count = heap_profile_top_sites(top, 3);
+    for (int i = 0; i < count; i++) {
+        snprintf(line, sizeof(line), "  0x%x: %d bytes in %d allocs\n",
+                 top[i].caller, top[i].live_bytes, top[i].live_count);
+        terminal_append(line);
+    }
+}
+
+// Lists the IRQ lines that have fired with their worst latency and
+// handler time, then the cli sections timed so far; irq_stats() writes the
+// full histograms to serial and also covers exceptions and stray vectors
+static void showInterrupts() {
+    irq_stats();
+
+    char line[64];
+    snprintf(line, sizeof(line), "IRQ: count, max latency, max handler at %u kHz\n", tsc_khz());
+    terminal_append(line);
+    for (int irq = 0; irq < IRQ_LINES; irq++) {
+        if (!irq_count(irq)) continue;
+        snprintf(line, sizeof(line), "  IRQ %d: %u  %u  %u\n", irq, irq_count(irq),
+                 irq_latency_histogram(irq)->max, irq_duration_histogram(irq)->max);
+        terminal_append(line);
+    }
+
+    uint32_t site;
+    uint32_t longest = irq_longest_off(&site);
+    snprintf(line, sizeof(line), "  spurious: %u\n", spurious_irq_count());
+    terminal_append(line);
+    snprintf(line, sizeof(line), "cli sections: %u, longest %u at 0x%x\n",
+             irq_off_histogram()->count, longest, site);
+    terminal_append(line);
+}
+
 void executeCommand() {
+    // Start over rather than overflow the buffer with a long report
+    if (terminal_length > TERMINAL_BUFFER_SIZE - 512) {
+        terminal_set("SCos Terminal v1.0\n> ");
+    }
+
     // Add command to buffer
-    terminal_strcat(terminal_buffer, current_line);
-    terminal_strcat(terminal_buffer, "\n");
+    terminal_append(StrView(current_line, cursor_pos));
+    terminal_append("\n");
 
     // Simple command processing
-    if (current_line[0] == 'h' && current_line[1] == 'e') { // help
-        terminal_strcat(terminal_buffer, "Available commands:\n");
-        terminal_strcat(terminal_buffer, "  help - Show this help\n");
-        terminal_strcat(terminal_buffer, "  clear - Clear screen\n");
-        terminal_strcat(terminal_buffer, "  exit - Close terminal\n");
+    if (current_line[0] == 'h' && current_line[1] == 'e' && current_line[2] == 'a') { // heap
+        showHeapProfile();
+    } else if (current_line[0] == 'h' && current_line[1] == 'e') { // help
+        terminal_append("Available commands:\n");
+        terminal_append("  help - Show this help\n");
+        terminal_append("  clear - Clear screen\n");
+        terminal_append("  heap - Heap usage profile\n");
+        terminal_append("  irq - Interrupt latency and cli sections\n");
+        terminal_append("  locks - Lock contention to serial\n");
+        terminal_append("  ps - List threads, fibers and CPUs to serial\n");
+        terminal_append("  trace - Dump event trace to serial\n");
+        terminal_append("  exit - Close terminal\n");
+    } else if (current_line[0] == 'i' && current_line[1] == 'r') { // irq
+        showInterrupts();
+    } else if (current_line[0] == 'l' && current_line[1] == 'o') { // locks
+        lock_stats_dump();
+        terminal_append("Lock statistics written to serial\n");
+    } else if (current_line[0] == 'p' && current_line[1] == 's') { // ps
+        thread_stats();
+        fiber_stats();
+        smp_stats();
+        terminal_append("Thread list written to serial\n");
+    } else if (current_line[0] == 't' && current_line[1] == 'r') { // trace
+        trace_dump();
+        terminal_append("Trace written to serial\n");
     } else if (current_line[0] == 'c' && current_line[1] == 'l') { // clear
-        terminal_strcpy(terminal_buffer, "SCos Terminal v1.0\n");
+        terminal_set("SCos Terminal v1.0\n");
     } else if (current_line[0] == 'e' && current_line[1] == 'x') { // exit
         closeTerminal();
         return;
     } else if (current_line[0] != '\0') {
-        terminal_strcat(terminal_buffer, "Command not found: ");
-        terminal_strcat(terminal_buffer, current_line);
-        terminal_strcat(terminal_buffer, "\n");
+        terminal_append("Command not found: ");
+        terminal_append(StrView(current_line, cursor_pos));
+        terminal_append("\n");
     }
 
     // Add new prompt
-    terminal_strcat(terminal_buffer, "> ");
+    terminal_append("> ");
 
     // Clear current line
-    terminal_strcpy(current_line, "");
+    current_line[0] = '\0';
     cursor_pos = 0;
 
     drawTerminalContent();
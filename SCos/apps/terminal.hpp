@@ -5,6 +5,15 @@
 #define MAX_TERMINAL_LINES 16
 #define MAX_LINE_LENGTH 60
 
+// The desktop's terminal window. Keys arrive as characters from the
+// keyboard buffer, already translated through shift and caps lock.
+void runTerminal();
+void closeTerminal();
+bool isTerminalVisible();
+bool terminalHasFocus();
+void drawTerminalContent();
+void handleTerminalInput(char key);
+
 class Terminal {
 public:
     static void init();
@@ -1,6 +1,7 @@
 
 #include "updates.hpp"
 #include "../ui/window_manager.hpp"
+#include "../kernel/fiber.hpp"
 #include <stdint.h>
 
 // Updates state
@@ -23,6 +24,12 @@ static UpdateInfo available_updates[] = {
 static const int update_count = 6;
 static char install_progress[64];
 static int install_percent = 0;
+static fiber* install_fiber = nullptr;
+static int install_from = 0;
+static int install_to = 0;
+static bool install_cancelled = false;
+
+#define INSTALL_STEP_MS 100
 
 void UpdatesManager::init() {
     updates_visible = false;
@@ -46,6 +53,8 @@ void UpdatesManager::show() {
 void UpdatesManager::hide() {
     if (!updates_visible || updates_window_id < 0) return;
 
+    install_cancelled = true;
+
     WindowManager::closeWindow(updates_window_id);
     updates_visible = false;
     updates_window_id = -1;
@@ -250,6 +259,30 @@ void UpdatesManager::checkForUpdates() {
     checking_updates = false;
 }
 
+// Installs every available update from `from` to `to` in a fiber, so the
+// sequence reads top to bottom while input and drawing carry on
+void UpdatesManager::startInstall(int from, int to) {
+    if (install_fiber) return;
+
+    install_from = from;
+    install_to = to;
+    install_cancelled = false;
+    install_fiber = fiber_create("install", installUpdates, nullptr);
+}
+
+void UpdatesManager::installUpdates(void*) {
+    for (int i = install_from; i <= install_to && !install_cancelled; ++i) {
+        if (available_updates[i].available) {
+            installUpdate(i);
+        }
+    }
+
+    // Return to main screen
+    current_screen = 0;
+    drawUpdatesScreen();
+    install_fiber = nullptr;
+}
+
 void UpdatesManager::installUpdate(int update_index) {
     if (update_index < 0 || update_index >= update_count) return;
     
@@ -280,21 +313,19 @@ void UpdatesManager::installUpdate(int update_index) {
     
     drawUpdatesScreen();
     
-    // Simulate progress (in real implementation this would be actual installation)
-    for (int i = 0; i <= 100; i += 10) {
-        install_percent = i;
+    // Simulate progress (in real implementation this would be actual
+    // installation)
+    for (;;) {
+        fiber_sleep_ms(INSTALL_STEP_MS);
+        if (install_cancelled) return;
+        if (install_percent >= 100) break;
+
+        install_percent += 10;
         drawUpdatesScreen();
-        
-        // Simple delay simulation
-        for (volatile int j = 0; j < 1000000; ++j) { }
     }
     
     // Mark as no longer available (installed)
     available_updates[update_index].available = false;
-    
-    // Return to main screen
-    current_screen = 0;
-    drawUpdatesScreen();
 }
 
 void UpdatesManager::handleInput(uint8_t key) {
@@ -316,18 +347,14 @@ void UpdatesManager::handleInput(uint8_t key) {
                 break;
             case 0x1C: // Enter - Install selected
                 if (available_updates[selected_update].available) {
-                    installUpdate(selected_update);
+                    startInstall(selected_update, selected_update);
                 }
                 break;
             case 0x39: // Space - Show details
                 showUpdateDetails(selected_update);
                 break;
             case 0x1E: // A - Install all
-                for (int i = 0; i < update_count; ++i) {
-                    if (available_updates[i].available) {
-                        installUpdate(i);
-                    }
-                }
+                startInstall(0, update_count - 1);
                 break;
             case 0x2E: // C - Check for updates
                 checkForUpdates();
@@ -338,8 +365,9 @@ void UpdatesManager::handleInput(uint8_t key) {
                 break;
         }
     } else if (current_screen == 2) {
-        // During installation, only allow escape
+        // During installation, only allow escape, which abandons it
         if (key == 0x01) {
+            install_cancelled = true;
             current_screen = 0;
             drawUpdatesScreen();
         }
@@ -25,6 +25,8 @@ public:
 private:
     static void drawUpdatesScreen();
     static void checkForUpdates();
+    static void startInstall(int from, int to);
+    static void installUpdates(void* data);
     static void installUpdate(int update_index);
     static void showUpdateDetails(int update_index);
     static void downloadUpdate(const char* component);
@@ -0,0 +1,43 @@
+// The byte-at-a-time string routines lib/string.cpp used to have, kept as
+// the baseline for string_bench. Built with the kernel's flags (no -O).
+#include <stddef.h>
+
+extern "C" {
+void* byte_memset(void* ptr, int value, size_t size) {
+    unsigned char* p = (unsigned char*)ptr;
+    while (size--) {
+        *p++ = (unsigned char)value;
+    }
+    return ptr;
+}
+
+void* byte_memcpy(void* dest, const void* src, size_t size) {
+    unsigned char* d = (unsigned char*)dest;
+    const unsigned char* s = (const unsigned char*)src;
+    while (size--) {
+        *d++ = *s++;
+    }
+    return dest;
+}
+
+int byte_memcmp(const void* ptr1, const void* ptr2, size_t size) {
+    const unsigned char* p1 = (const unsigned char*)ptr1;
+    const unsigned char* p2 = (const unsigned char*)ptr2;
+    while (size--) {
+        if (*p1 != *p2) {
+            return *p1 - *p2;
+        }
+        p1++;
+        p2++;
+    }
+    return 0;
+}
+
+size_t byte_strlen(const char* str) {
+    size_t len = 0;
+    while (str[len]) {
+        len++;
+    }
+    return len;
+}
+}
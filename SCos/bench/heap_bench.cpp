@@ -0,0 +1,373 @@
+// Replays allocation traces against the kernel heap built for the host and
+// reports per-operation latency, throughput and peak fragmentation.
+//
+//   heap_bench                 run every built-in trace
+//   heap_bench NAME...         run the named built-in traces
+//   heap_bench --dump NAME     print a built-in trace in replay format
+//   heap_bench --trace FILE    replay a trace file
+//   heap_bench --stats         also print heap_stats() after each trace
+//
+// Trace files hold one operation per line: "a SLOT SIZE" allocates into a
+// slot, "r SLOT SIZE" reallocates it and "f SLOT" frees it.
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+#include "host_kernel.hpp"
+
+enum op_kind : uint8_t { OP_ALLOC, OP_REALLOC, OP_FREE };
+
+struct trace_op {
+    op_kind kind;
+    uint32_t slot;
+    uint32_t size;
+};
+
+struct trace {
+    const char* name;
+    std::vector<trace_op> ops;
+    uint32_t slots = 0;
+
+    void alloc(uint32_t slot, uint32_t size) { push(OP_ALLOC, slot, size); }
+    void realloc(uint32_t slot, uint32_t size) { push(OP_REALLOC, slot, size); }
+    void free(uint32_t slot) { push(OP_FREE, slot, 0); }
+
+    void push(op_kind kind, uint32_t slot, uint32_t size) {
+        ops.push_back({kind, slot, size});
+        if (slot >= slots) slots = slot + 1;
+    }
+};
+
+// Small deterministic generator so traces replay identically everywhere
+struct rng {
+    uint64_t state;
+    explicit rng(uint64_t seed) : state(seed * 0x9E3779B97F4A7C15ull + 1) {}
+    uint32_t next() {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return (uint32_t)(state >> 32);
+    }
+    uint32_t range(uint32_t lo, uint32_t hi) { return lo + next() % (hi - lo + 1); }
+};
+
+// Mostly small objects with a tail of buffers, as seen across the kernel
+static uint32_t mixed_size(rng& r) {
+    uint32_t pick = r.next() % 100;
+    if (pick < 70) return r.range(8, 128);
+    if (pick < 95) return r.range(129, 2048);
+    return r.range(2049, 32768);
+}
+
+static trace make_random() {
+    trace t{"random"};
+    rng r(1);
+    const uint32_t slots = 2048;
+    std::vector<bool> live(slots);
+    for (int i = 0; i < 200000; i++) {
+        uint32_t slot = r.next() % slots;
+        if (!live[slot]) {
+            t.alloc(slot, mixed_size(r));
+            live[slot] = true;
+        } else if (r.next() % 4 == 0) {
+            t.realloc(slot, mixed_size(r));
+        } else {
+            t.free(slot);
+            live[slot] = false;
+        }
+    }
+    for (uint32_t slot = 0; slot < slots; slot++) {
+        if (live[slot]) t.free(slot);
+    }
+    return t;
+}
+
+// Nested scopes allocating on the way in and freeing in reverse
+static trace make_lifo() {
+    trace t{"lifo"};
+    rng r(2);
+    for (int round = 0; round < 2000; round++) {
+        uint32_t depth = r.range(1, 256);
+        for (uint32_t i = 0; i < depth; i++) t.alloc(i, r.range(16, 1024));
+        for (uint32_t i = depth; i-- > 0;) t.free(i);
+    }
+    return t;
+}
+
+// A bounded queue of message buffers: the oldest is freed as each new one
+// arrives, so lifetimes overlap but never nest
+static trace make_producer_consumer() {
+    trace t{"producer-consumer"};
+    rng r(3);
+    const uint32_t depth = 512;
+    const uint32_t messages = 100000;
+    for (uint32_t i = 0; i < messages; i++) {
+        if (i >= depth) t.free((i - depth) % depth);
+        t.alloc(i % depth, r.range(32, 4096));
+    }
+    for (uint32_t i = messages - depth; i < messages; i++) t.free(i % depth);
+    return t;
+}
+
+// Page loads in the style of apps/html_interpreter.cpp: an element record
+// per tag, a few attribute strings, text that grows as it is appended to,
+// then the whole document torn down at once.
+static trace make_html_parse() {
+    trace t{"html-parse"};
+    rng r(4);
+    const uint32_t element_size = 1000;
+    for (int page = 0; page < 300; page++) {
+        uint32_t slot = 0;
+        uint32_t elements = r.range(50, 200);
+        for (uint32_t e = 0; e < elements; e++) {
+            t.alloc(slot++, element_size);
+            uint32_t attributes = r.range(0, 3);
+            for (uint32_t a = 0; a < attributes; a++) t.alloc(slot++, r.range(8, 64));
+            if (r.next() % 2) {
+                uint32_t text = slot++;
+                uint32_t length = r.range(16, 64);
+                t.alloc(text, length);
+                for (uint32_t grow = r.range(0, 4); grow > 0; grow--) {
+                    length += r.range(16, 128);
+                    t.realloc(text, length);
+                }
+            }
+        }
+        for (uint32_t css = r.range(10, 60); css > 0; css--) t.alloc(slot++, r.range(64, 200));
+        for (uint32_t i = 0; i < slot; i++) t.free(i);
+    }
+    return t;
+}
+
+static bool load_trace(const char* path, trace& t) {
+    FILE* file = fopen(path, "r");
+    if (!file) {
+        perror(path);
+        return false;
+    }
+
+    char kind;
+    unsigned slot, size;
+    char line[64];
+    while (fgets(line, sizeof(line), file)) {
+        int fields = sscanf(line, " %c %u %u", &kind, &slot, &size);
+        if (fields < 2) continue;
+        if (kind == 'a' && fields == 3) t.alloc(slot, size);
+        else if (kind == 'r' && fields == 3) t.realloc(slot, size);
+        else if (kind == 'f') t.free(slot);
+        else fprintf(stderr, "%s: bad line: %s", path, line);
+    }
+    fclose(file);
+    return true;
+}
+
+static void dump_trace(const trace& t) {
+    for (const trace_op& op : t.ops) {
+        if (op.kind == OP_FREE) printf("f %u\n", op.slot);
+        else printf("%c %u %u\n", op.kind == OP_ALLOC ? 'a' : 'r', op.slot, op.size);
+    }
+}
+
+static inline uint64_t now_ns() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+// Cost of one now_ns() pair, subtracted from every timed operation
+static uint64_t timer_overhead_ns() {
+    const int rounds = 100000;
+    uint64_t start = now_ns();
+    for (int i = 0; i < rounds; i++) {
+        volatile uint64_t a = now_ns();
+        volatile uint64_t b = now_ns();
+        (void)a;
+        (void)b;
+    }
+    return (now_ns() - start) / rounds;
+}
+
+// The allocators keep their state in statics and can only be initialized
+// once per process, so every pass runs in a forked child
+static bool init_allocators() {
+    host_kernel_quiet(true);
+    bool ok = init_heap() && init_buddy();
+    host_kernel_quiet(false);
+    return ok;
+}
+
+static inline void run_op(const trace_op& op, void** ptrs) {
+    switch (op.kind) {
+        case OP_ALLOC:
+            ptrs[op.slot] = kmalloc(op.size);
+            if (ptrs[op.slot]) *(volatile uint8_t*)ptrs[op.slot] = 1;
+            break;
+        case OP_REALLOC: {
+            void* ptr = krealloc(ptrs[op.slot], op.size);
+            if (ptr) ptrs[op.slot] = ptr;
+            break;
+        }
+        case OP_FREE:
+            kfree(ptrs[op.slot]);
+            ptrs[op.slot] = nullptr;
+            break;
+    }
+}
+
+struct result {
+    uint64_t ns[3] = {};
+    uint64_t count[3] = {};
+    uint64_t failed = 0;
+    double mops = 0;
+    uint32_t peak_fragmentation = 0;
+    uint32_t peak_live_kb = 0;
+};
+
+// Per-operation latency and fragmentation samples
+static bool timed_pass(const trace& t, uint64_t overhead, bool stats, result& out) {
+    std::vector<void*> ptrs(t.slots);
+    if (!init_allocators()) return false;
+    for (size_t i = 0; i < t.ops.size(); i++) {
+        const trace_op& op = t.ops[i];
+        uint64_t start = now_ns();
+        run_op(op, ptrs.data());
+        uint64_t elapsed = now_ns() - start;
+        out.ns[op.kind] += elapsed > overhead ? elapsed - overhead : 0;
+        out.count[op.kind]++;
+        if (op.kind != OP_FREE && !ptrs[op.slot]) out.failed++;
+
+        if ((i & 255) == 0) {
+            uint32_t free_bytes, largest;
+            heap_free_space(&free_bytes, &largest);
+            uint32_t fragmentation = free_bytes ? 100 - (uint32_t)((uint64_t)largest * 100 / free_bytes) : 0;
+            if (fragmentation > out.peak_fragmentation) out.peak_fragmentation = fragmentation;
+        }
+    }
+
+    heap_profile_summary summary;
+    heap_profile_get_summary(&summary);
+    out.peak_live_kb = summary.peak_bytes / 1024;
+    if (stats) heap_stats();
+    return true;
+}
+
+// Raw throughput with no instrumentation between operations
+static bool throughput_pass(const trace& t, uint64_t, bool, result& out) {
+    std::vector<void*> ptrs(t.slots);
+    if (!init_allocators()) return false;
+    uint64_t start = now_ns();
+    for (const trace_op& op : t.ops) run_op(op, ptrs.data());
+    uint64_t elapsed = now_ns() - start;
+    out.mops = elapsed ? (double)t.ops.size() * 1000.0 / elapsed : 0;
+    return true;
+}
+
+typedef bool (*pass_fn)(const trace&, uint64_t, bool, result&);
+
+static bool run_in_child(pass_fn pass, const trace& t, uint64_t overhead, bool stats, result& out) {
+    int fds[2];
+    if (pipe(fds) != 0) return false;
+
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid == 0) {
+        close(fds[0]);
+        bool ok = pass(t, overhead, stats, out);
+        fflush(stdout);
+        if (ok && write(fds[1], &out, sizeof(out)) != sizeof(out)) ok = false;
+        _exit(ok ? 0 : 1);
+    }
+
+    close(fds[1]);
+    bool ok = pid > 0 && read(fds[0], &out, sizeof(out)) == sizeof(out);
+    close(fds[0]);
+    int status;
+    if (pid > 0) waitpid(pid, &status, 0);
+    return ok;
+}
+
+static bool run_trace(const trace& t, uint64_t overhead, bool stats, result& out) {
+    result throughput;
+    if (!run_in_child(timed_pass, t, overhead, stats, out)) return false;
+    if (!run_in_child(throughput_pass, t, overhead, false, throughput)) return false;
+    out.mops = throughput.mops;
+    return true;
+}
+
+static double per_op(const result& r, op_kind kind) {
+    return r.count[kind] ? (double)r.ns[kind] / r.count[kind] : 0;
+}
+
+static void print_header() {
+    printf("%-18s %9s %11s %9s %12s %8s %9s %9s\n", "trace", "ops", "kmalloc ns",
+           "kfree ns", "krealloc ns", "Mops/s", "peak KB", "peak frag");
+}
+
+static void print_result(const trace& t, const result& r) {
+    printf("%-18s %9zu %11.1f %9.1f %12.1f %8.2f %9u %8u%%", t.name, t.ops.size(),
+           per_op(r, OP_ALLOC), per_op(r, OP_FREE), per_op(r, OP_REALLOC), r.mops,
+           r.peak_live_kb, r.peak_fragmentation);
+    if (r.failed) printf("  (%llu failed)", (unsigned long long)r.failed);
+    printf("\n");
+}
+
+int main(int argc, char** argv) {
+    trace (*builtins[])() = {make_random, make_lifo, make_producer_consumer, make_html_parse};
+    std::vector<trace> traces;
+    bool stats = false;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--stats")) {
+            stats = true;
+        } else if (!strcmp(argv[i], "--trace") && i + 1 < argc) {
+            trace t{argv[++i]};
+            if (!load_trace(t.name, t)) return 1;
+            traces.push_back(t);
+        } else if (!strcmp(argv[i], "--dump") && i + 1 < argc) {
+            const char* name = argv[++i];
+            for (auto make : builtins) {
+                trace t = make();
+                if (!strcmp(t.name, name)) {
+                    dump_trace(t);
+                    return 0;
+                }
+            }
+            fprintf(stderr, "unknown trace: %s\n", name);
+            return 1;
+        } else {
+            bool found = false;
+            for (auto make : builtins) {
+                trace t = make();
+                if (!strcmp(t.name, argv[i])) {
+                    traces.push_back(t);
+                    found = true;
+                }
+            }
+            if (!found) {
+                fprintf(stderr, "unknown trace: %s\n", argv[i]);
+                return 1;
+            }
+        }
+    }
+    if (traces.empty()) {
+        for (auto make : builtins) traces.push_back(make());
+    }
+
+    uint64_t overhead = timer_overhead_ns();
+    printf("timer overhead %llu ns per sample (subtracted)\n", (unsigned long long)overhead);
+    print_header();
+    for (const trace& t : traces) {
+        result r;
+        if (!run_trace(t, overhead, stats, r)) {
+            fprintf(stderr, "%s: benchmark pass failed\n", t.name);
+            return 1;
+        }
+        print_result(t, r);
+    }
+    return 0;
+}
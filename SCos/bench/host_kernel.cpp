@@ -0,0 +1,83 @@
+// Host stand-ins for the kernel services memory/heap.cpp and
+// memory/buddy.cpp depend on. The heap and page-allocator windows are
+// real anonymous mappings at their kernel addresses, so Linux provides
+// the same demand-zero behaviour the page-fault handler does on target.
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <sys/mman.h>
+
+#include "host_kernel.hpp"
+
+#define HOST_PAGE_SIZE 4096
+#define HOST_MAX_REGIONS 4
+
+static int region_count = 0;
+static bool serial_quiet = false;
+
+bool paging_add_demand_region(uint32_t base, uint32_t size) {
+    if (region_count == HOST_MAX_REGIONS) return false;
+
+    void* mem = mmap((void*)(uintptr_t)base, size, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE | MAP_NORESERVE, -1, 0);
+    if (mem != (void*)(uintptr_t)base) {
+        perror("mmap");
+        return false;
+    }
+
+    region_count++;
+    return true;
+}
+
+// Dropping the page mirrors the kernel returning its frame; the next touch
+// faults in a fresh zero page
+uint32_t paging_unmap_page(uint32_t virt) {
+    madvise((void*)(uintptr_t)virt, HOST_PAGE_SIZE, MADV_DONTNEED);
+    return 0;
+}
+
+void pmm_free_frame(uint32_t) {}
+
+uint32_t pmm_free_frames() {
+    return 0x100000;
+}
+
+void pmm_stats() {}
+void paging_stats() {}
+
+void serial_printf(const char* format, ...) {
+    if (serial_quiet) return;
+
+    va_list args;
+    va_start(args, format);
+    vprintf(format, args);
+    va_end(args);
+}
+
+// debug/log.hpp's runtime mask; every subsystem stays enabled
+uint32_t log_mask = ~0u;
+
+void log_write(int level, const char* format, ...) {
+    if (serial_quiet) return;
+
+    if (level == 1) {
+        fputs("ERROR: ", stdout);
+    } else if (level == 2) {
+        fputs("WARNING: ", stdout);
+    }
+
+    va_list args;
+    va_start(args, format);
+    vprintf(format, args);
+    va_end(args);
+}
+
+// kernel/thread.hpp's preemption guard; the bench is single-threaded
+volatile uint32_t preempt_count = 0;
+volatile bool need_resched = false;
+
+void preempt_schedule() {}
+
+void host_kernel_quiet(bool quiet) {
+    serial_quiet = quiet;
+}
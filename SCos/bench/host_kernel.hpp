@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstdint>
+
+// Kernel allocator entry points as seen from a host build. The kernel's
+// size_t is 32 bits, so sizes cross this boundary as uint32_t.
+extern "C" {
+    void* kmalloc(uint32_t size);
+    void kfree(void* ptr);
+}
+
+bool init_heap();
+bool init_buddy();
+void* kmalloc_aligned(uint32_t size, uint32_t align);
+void* krealloc(void* ptr, uint32_t size);
+void heap_free_space(uint32_t* total, uint32_t* largest);
+void heap_stats();
+
+// Mirrors memory/heap_profile.hpp, which cannot be included next to libc
+struct heap_profile_summary {
+    uint32_t live_bytes;
+    uint32_t peak_bytes;
+    uint32_t live_count;
+    uint32_t total_count;
+    uint32_t untracked;
+    uint32_t free_bytes;
+    uint32_t largest_free;
+};
+
+void heap_profile_get_summary(heap_profile_summary* summary);
+
+void host_kernel_quiet(bool quiet);
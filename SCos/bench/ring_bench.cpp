@@ -0,0 +1,238 @@
+// Stress test and throughput benchmark for the lock-free rings in
+// kernel/ring.hpp, with host threads standing in for the IRQ handlers and
+// CPUs that feed them.
+//
+//   ring_bench            check every ring, then time them
+//   ring_bench --check    only run the stress test
+//
+// The stress test pushes numbered items through each ring and fails if the
+// consumer sees one lost, duplicated or out of order for its producer. The
+// benchmark reports items per second through single and bulk calls, next
+// to a mutex-guarded ring as the baseline.
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "../kernel/ring.hpp"
+
+#define RING_SIZE 1024
+#define BULK 32
+#define MAX_PRODUCERS 4
+
+// Producer number in the top byte, sequence number below it
+static inline uint32_t make_item(uint32_t producer, uint32_t sequence) {
+    return (producer << 24) | sequence;
+}
+
+static inline uint64_t now_ns() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+// What the original keyboard buffer did, made thread-safe with a mutex
+template <typename T, uint32_t N>
+struct MutexRing {
+    std::mutex lock;
+    T slots[N];
+    uint32_t head = 0;
+    uint32_t tail = 0;
+
+    bool push(const T& item) {
+        std::lock_guard<std::mutex> guard(lock);
+        uint32_t next = (head + 1) % N;
+        if (next == tail) return false;
+        slots[head] = item;
+        head = next;
+        return true;
+    }
+
+    uint32_t push_bulk(const T* items, uint32_t count) {
+        std::lock_guard<std::mutex> guard(lock);
+        uint32_t pushed = 0;
+        while (pushed < count && (head + 1) % N != tail) {
+            slots[head] = items[pushed++];
+            head = (head + 1) % N;
+        }
+        return pushed;
+    }
+
+    bool pop(T* item) {
+        std::lock_guard<std::mutex> guard(lock);
+        if (head == tail) return false;
+        *item = slots[tail];
+        tail = (tail + 1) % N;
+        return true;
+    }
+
+    uint32_t pop_bulk(T* items, uint32_t max) {
+        std::lock_guard<std::mutex> guard(lock);
+        uint32_t popped = 0;
+        while (popped < max && head != tail) {
+            items[popped++] = slots[tail];
+            tail = (tail + 1) % N;
+        }
+        return popped;
+    }
+};
+
+// Runs producers against one consumer and checks every item arrives once
+// and in order per producer. Returns items per second, or a negative
+// value if the check failed.
+template <typename Ring>
+static double run(Ring& ring, uint32_t producers, uint32_t per_producer, bool bulk) {
+    std::atomic<bool> start(false);
+    std::vector<std::thread> threads;
+
+    for (uint32_t p = 0; p < producers; p++) {
+        threads.emplace_back([&ring, &start, p, per_producer, bulk] {
+            while (!start.load(std::memory_order_acquire)) std::this_thread::yield();
+            uint32_t items[BULK];
+            uint32_t sent = 0;
+            while (sent < per_producer) {
+                uint32_t pushed;
+                if (bulk) {
+                    uint32_t count = per_producer - sent < BULK ? per_producer - sent : BULK;
+                    for (uint32_t i = 0; i < count; i++) items[i] = make_item(p, sent + i);
+                    pushed = ring.push_bulk(items, count);
+                } else {
+                    pushed = ring.push(make_item(p, sent)) ? 1 : 0;
+                }
+                if (!pushed) std::this_thread::yield();
+                sent += pushed;
+            }
+        });
+    }
+
+    uint32_t expected[MAX_PRODUCERS] = {};
+    uint64_t total = (uint64_t)producers * per_producer;
+    uint64_t received = 0;
+    bool ok = true;
+
+    uint64_t begin = now_ns();
+    start.store(true, std::memory_order_release);
+    uint32_t items[BULK];
+    while (received < total) {
+        uint32_t count = bulk ? ring.pop_bulk(items, BULK) : ring.pop(&items[0]) ? 1 : 0;
+        // Lets the producers run when there are fewer cores than threads
+        if (!count) std::this_thread::yield();
+        for (uint32_t i = 0; i < count; i++) {
+            uint32_t producer = items[i] >> 24;
+            uint32_t sequence = items[i] & 0xFFFFFF;
+            if (producer >= producers || sequence != expected[producer]) {
+                if (ok) {
+                    printf("  item %u from producer %u, expected %u\n", sequence, producer,
+                           producer < producers ? expected[producer] : 0);
+                }
+                ok = false;
+                continue;
+            }
+            expected[producer]++;
+        }
+        received += count;
+    }
+    uint64_t elapsed = now_ns() - begin;
+
+    for (std::thread& thread : threads) thread.join();
+    uint32_t leftover;
+    if (ring.pop(&leftover)) {
+        printf("  ring not empty after the run\n");
+        ok = false;
+    }
+    if (!ok) return -1;
+    return (double)total * 1e9 / (elapsed ? elapsed : 1);
+}
+
+// Fills, wraps and drains a ring from one thread, so boundary mistakes show
+// up deterministically before any threads run
+template <typename Ring>
+static bool check_single_thread(const char* name) {
+    static Ring ring;
+    uint32_t items[RING_SIZE + 1];
+    for (uint32_t round = 0; round < 3; round++) {
+        uint32_t base = round * RING_SIZE;
+        for (uint32_t i = 0; i < RING_SIZE; i++) {
+            if (!ring.push(base + i)) {
+                printf("%s: push %u failed with room left\n", name, i);
+                return false;
+            }
+        }
+        if (ring.push(0) || ring.size() != RING_SIZE) {
+            printf("%s: full ring took another item\n", name);
+            return false;
+        }
+        uint32_t half = ring.pop_bulk(items, RING_SIZE / 2);
+        uint32_t rest = ring.pop_bulk(items + half, RING_SIZE);
+        if (half + rest != RING_SIZE || !ring.empty()) {
+            printf("%s: drained %u of %u items\n", name, half + rest, RING_SIZE);
+            return false;
+        }
+        for (uint32_t i = 0; i < RING_SIZE; i++) {
+            if (items[i] != base + i) {
+                printf("%s: item %u came out as %u\n", name, base + i, items[i]);
+                return false;
+            }
+        }
+        // Leave the indices off a multiple of the size for the next round
+        ring.push_bulk(items, 3);
+        ring.pop_bulk(items, 3);
+    }
+    return true;
+}
+
+typedef SpscRing<uint32_t, RING_SIZE> spsc_ring;
+typedef MpscRing<uint32_t, RING_SIZE> mpsc_ring;
+typedef MutexRing<uint32_t, RING_SIZE> mutex_ring;
+
+static bool check() {
+    if (!check_single_thread<spsc_ring>("SpscRing")) return false;
+    if (!check_single_thread<mpsc_ring>("MpscRing")) return false;
+
+    const uint32_t items = 2000000;
+    for (int bulk = 0; bulk < 2; bulk++) {
+        static spsc_ring spsc;
+        if (run(spsc, 1, items, bulk) < 0) {
+            printf("SpscRing failed the %s stress test\n", bulk ? "bulk" : "single");
+            return false;
+        }
+        for (uint32_t producers = 1; producers <= MAX_PRODUCERS; producers *= 2) {
+            static mpsc_ring mpsc;
+            if (run(mpsc, producers, items / producers, bulk) < 0) {
+                printf("MpscRing failed the %s stress test with %u producers\n",
+                       bulk ? "bulk" : "single", producers);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+template <typename Ring>
+static void report(const char* name, uint32_t producers) {
+    static Ring ring;
+    const uint32_t items = 4000000;
+    for (int bulk = 0; bulk < 2; bulk++) {
+        double rate = run(ring, producers, items / producers, bulk);
+        printf("%-10s %9u %6s %14.1f\n", name, producers, bulk ? "bulk" : "single", rate / 1e6);
+    }
+}
+
+int main(int argc, char** argv) {
+    if (!check()) return 1;
+    printf("SpscRing and MpscRing passed the stress test\n\n");
+    if (argc > 1 && !strcmp(argv[1], "--check")) return 0;
+
+    printf("%-10s %9s %6s %14s\n", "ring", "producers", "calls", "Mitems/s");
+    report<spsc_ring>("spsc", 1);
+    report<mutex_ring>("mutex", 1);
+    for (uint32_t producers = 2; producers <= MAX_PRODUCERS; producers *= 2) {
+        report<mpsc_ring>("mpsc", producers);
+        report<mutex_ring>("mutex", producers);
+    }
+    return 0;
+}
@@ -0,0 +1,133 @@
+// Checks the lib/string.cpp routines against the byte-at-a-time versions
+// they replaced, then times both across sizes and alignments.
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+
+// lib/string.cpp is built for the host with its symbols prefixed so it
+// does not replace the C library's own routines in this process
+extern "C" {
+    void* kernel_memset(void* ptr, int value, uint32_t size);
+    void* kernel_memcpy(void* dest, const void* src, uint32_t size);
+    int kernel_memcmp(const void* ptr1, const void* ptr2, uint32_t size);
+    uint32_t kernel_strlen(const char* str);
+
+    void* byte_memset(void* ptr, int value, uint32_t size);
+    void* byte_memcpy(void* dest, const void* src, uint32_t size);
+    int byte_memcmp(const void* ptr1, const void* ptr2, uint32_t size);
+    uint32_t byte_strlen(const char* str);
+}
+
+#define BUFFER_SIZE (64 * 1024 + 64)
+
+static unsigned char src_buffer[BUFFER_SIZE];
+static unsigned char dst_buffer[BUFFER_SIZE];
+static unsigned char ref_buffer[BUFFER_SIZE];
+
+static int sign(int value) {
+    return (value > 0) - (value < 0);
+}
+
+static bool check() {
+    for (uint32_t i = 0; i < BUFFER_SIZE; i++) src_buffer[i] = (unsigned char)(i * 7 + 1);
+
+    for (uint32_t offset = 0; offset < 4; offset++) {
+        for (uint32_t dst_offset = 0; dst_offset < 4; dst_offset++) {
+            for (uint32_t size = 0; size < 300; size++) {
+                memset(dst_buffer, 0xEE, 512);
+                memset(ref_buffer, 0xEE, 512);
+                kernel_memcpy(dst_buffer + dst_offset, src_buffer + offset, size);
+                byte_memcpy(ref_buffer + dst_offset, src_buffer + offset, size);
+                if (memcmp(dst_buffer, ref_buffer, 512)) {
+                    printf("memcpy mismatch: size %u, offsets %u/%u\n", size, offset, dst_offset);
+                    return false;
+                }
+
+                kernel_memset(dst_buffer + dst_offset, 0x5A + size, size);
+                byte_memset(ref_buffer + dst_offset, 0x5A + size, size);
+                if (memcmp(dst_buffer, ref_buffer, 512)) {
+                    printf("memset mismatch: size %u, offset %u\n", size, dst_offset);
+                    return false;
+                }
+
+                memcpy(dst_buffer + dst_offset, src_buffer + offset, size);
+                if (size) dst_buffer[dst_offset + size - 1 - (size * 13) % size] ^= 0x80;
+                int expected = byte_memcmp(src_buffer + offset, dst_buffer + dst_offset, size);
+                int actual = kernel_memcmp(src_buffer + offset, dst_buffer + dst_offset, size);
+                if (sign(expected) != sign(actual)) {
+                    printf("memcmp mismatch: size %u, offsets %u/%u\n", size, offset, dst_offset);
+                    return false;
+                }
+
+                memset(dst_buffer, 'x', 512);
+                dst_buffer[offset + size] = '\0';
+                if (kernel_strlen((char*)dst_buffer + offset) != size) {
+                    printf("strlen mismatch: size %u, offset %u\n", size, offset);
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+static inline uint64_t now_ns() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+// Repeats each call until roughly 64 MB has been processed
+static uint32_t iterations(uint32_t size) {
+    uint32_t count = (64u << 20) / (size + 16);
+    return count > 2000000 ? 2000000 : count;
+}
+
+enum routine { MEMCPY, MEMSET, MEMCMP, STRLEN };
+
+static double time_routine(routine which, bool kernel, uint32_t size, uint32_t offset) {
+    unsigned char* dst = dst_buffer + offset;
+    unsigned char* src = src_buffer + offset;
+    if (which == STRLEN || which == MEMCMP) {
+        memset(src, 'x', size);
+        memset(dst, 'x', size);
+        src[size] = '\0';
+    }
+
+    uint32_t count = iterations(size);
+    volatile uint32_t sink = 0;
+    uint64_t start = now_ns();
+    for (uint32_t i = 0; i < count; i++) {
+        switch (which) {
+            case MEMCPY: kernel ? kernel_memcpy(dst, src, size) : byte_memcpy(dst, src, size); break;
+            case MEMSET: kernel ? kernel_memset(dst, i, size) : byte_memset(dst, i, size); break;
+            case MEMCMP: sink += kernel ? kernel_memcmp(dst, src, size) : byte_memcmp(dst, src, size); break;
+            case STRLEN: sink += kernel ? kernel_strlen((char*)src) : byte_strlen((char*)src); break;
+        }
+    }
+    return (double)(now_ns() - start) / count;
+}
+
+int main() {
+    if (!check()) return 1;
+    printf("lib/string.cpp matches the byte routines\n\n");
+
+    const char* names[] = {"memcpy", "memset", "memcmp", "strlen"};
+    const uint32_t sizes[] = {8, 32, 256, 4096, 65536};
+    const uint32_t offsets[] = {0, 1};
+
+    printf("%-8s %7s %6s %12s %12s %8s\n", "routine", "size", "align", "byte ns", "word ns", "speedup");
+    for (int which = MEMCPY; which <= STRLEN; which++) {
+        for (uint32_t size : sizes) {
+            for (uint32_t offset : offsets) {
+                double byte_ns = time_routine((routine)which, false, size, offset);
+                double word_ns = time_routine((routine)which, true, size, offset);
+                printf("%-8s %7u %6u %12.1f %12.1f %7.1fx\n", names[which], size, offset,
+                       byte_ns, word_ns, word_ns > 0 ? byte_ns / word_ns : 0);
+            }
+        }
+    }
+    return 0;
+}
@@ -49,6 +49,34 @@ mov ah, 0x0E
 add al, 0x30
 int 0x10
 
+; Collect the BIOS E820 memory map at 0x500 for the kernel's frame
+; allocator: a 16-bit entry count, then 24-byte entries from 0x504.
+; At most E820_MAX entries are kept so the map stays clear of the kernel
+; at 0x1000; memory/pmm.hpp has the same limit as E820_MAX_ENTRIES.
+E820_MAP equ 0x500
+E820_MAX equ 32
+xor ax, ax
+mov es, ax
+xor ebx, ebx
+xor bp, bp
+mov di, E820_MAP + 4
+e820_next:
+mov eax, 0xE820
+mov edx, 0x534D4150
+mov ecx, 24
+int 0x15
+jc e820_done
+cmp eax, 0x534D4150
+jne e820_done
+add di, 24
+inc bp
+cmp bp, E820_MAX
+jae e820_done
+test ebx, ebx
+jnz e820_next
+e820_done:
+mov [E820_MAP], bp
+
 mov si, kernel_msg
 call print_string
 
@@ -164,7 +192,7 @@ gdt_descriptor:
 
 boot_msg db 'SCos Bootloader Starting...', 13, 10, 0
 kernel_msg db 'Kernel loaded, switching to protected mode...', 13, 10, 0
-pmode_msg db 'Protected mode active, jumping to kernel...', 0
+pmode_msg db 'Protected mode active', 0
 jump_msg db 'Executing kernel jump...', 0
 error_msg db 'Disk read error!', 13, 10, 0
 
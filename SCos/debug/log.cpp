@@ -0,0 +1,32 @@
+#include "log.hpp"
+#include "serial.hpp"
+#include <stdarg.h>
+
+// Everything is logged until init_log() runs, so early boot is not lost
+uint32_t log_mask = LOG_ALL_SUBSYSTEMS;
+
+bool init_log() {
+    log_mask = LOG_ALL_SUBSYSTEMS;
+    return true;
+}
+
+void log_enable(log_subsystem subsystem, bool enabled) {
+    if (enabled) {
+        log_mask |= 1u << subsystem;
+    } else {
+        log_mask &= ~(1u << subsystem);
+    }
+}
+
+void log_write(int level, const char* format, ...) {
+    if (level == LOG_LEVEL_ERROR) {
+        serial_write("ERROR: ");
+    } else if (level == LOG_LEVEL_WARN) {
+        serial_write("WARNING: ");
+    }
+
+    va_list args;
+    va_start(args, format);
+    serial_vprintf(format, args);
+    va_end(args);
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <stdint.h>
+
+// Leveled kernel logging. Levels above LOG_LEVEL are removed by the
+// preprocessor, arguments included, so a build with a low threshold has
+// no logging code left in them. Enabled levels are also filtered at run
+// time by a per-subsystem mask.
+
+#define LOG_LEVEL_NONE 0
+#define LOG_LEVEL_ERROR 1
+#define LOG_LEVEL_WARN 2
+#define LOG_LEVEL_INFO 3
+#define LOG_LEVEL_DEBUG 4
+#define LOG_LEVEL_TRACE 5
+
+// Set from the Makefile; release builds use LOG_LEVEL_WARN
+#ifndef LOG_LEVEL
+#define LOG_LEVEL LOG_LEVEL_INFO
+#endif
+
+enum log_subsystem {
+    LOG_KERNEL,
+    LOG_MEMORY,
+    LOG_INTERRUPT,
+    LOG_NETWORK,
+    LOG_BLUETOOTH,
+    LOG_SUBSYSTEM_COUNT
+};
+
+#define LOG_ALL_SUBSYSTEMS ((1u << LOG_SUBSYSTEM_COUNT) - 1)
+
+// Bit n enables subsystem n; all are on after init_log()
+extern uint32_t log_mask;
+
+bool init_log();
+void log_enable(log_subsystem subsystem, bool enabled);
+void log_write(int level, const char* format, ...) __attribute__((format(printf, 2, 3)));
+
+#define LOG_AT(level, subsystem, ...)                   \
+    do {                                                \
+        if (log_mask & (1u << (subsystem))) {           \
+            log_write((level), __VA_ARGS__);            \
+        }                                               \
+    } while (0)
+
+#if LOG_LEVEL >= LOG_LEVEL_ERROR
+#define log_error(subsystem, ...) LOG_AT(LOG_LEVEL_ERROR, subsystem, __VA_ARGS__)
+#else
+#define log_error(subsystem, ...) ((void)0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_WARN
+#define log_warn(subsystem, ...) LOG_AT(LOG_LEVEL_WARN, subsystem, __VA_ARGS__)
+#else
+#define log_warn(subsystem, ...) ((void)0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_INFO
+#define log_info(subsystem, ...) LOG_AT(LOG_LEVEL_INFO, subsystem, __VA_ARGS__)
+#else
+#define log_info(subsystem, ...) ((void)0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_DEBUG
+#define log_debug(subsystem, ...) LOG_AT(LOG_LEVEL_DEBUG, subsystem, __VA_ARGS__)
+#else
+#define log_debug(subsystem, ...) ((void)0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_TRACE
+#define log_trace(subsystem, ...) LOG_AT(LOG_LEVEL_TRACE, subsystem, __VA_ARGS__)
+#else
+#define log_trace(subsystem, ...) ((void)0)
+#endif
@@ -1,9 +1,40 @@
 #include "serial.hpp"
 #include <stdint.h>
 #include <stdarg.h>
+#include "../include/format.hpp"
+#include "../include/string.h"
+#include "../interrupt/irq.hpp"
+#include "../kernel/spinlock.hpp"
 
 #define SERIAL_PORT 0x3f8
 
+// UART registers relative to SERIAL_PORT
+#define SERIAL_IER 1
+#define SERIAL_IIR 2
+#define SERIAL_LSR 5
+
+#define SERIAL_IER_THRE 0x02
+#define SERIAL_LSR_THRE 0x20
+// The 16550 FIFO enabled in init_serial takes this many bytes once empty
+#define SERIAL_FIFO_SIZE 16
+
+// Power of two so the free-running indices wrap with a mask
+#define SERIAL_TX_SIZE 4096
+#define SERIAL_TX_MASK (SERIAL_TX_SIZE - 1)
+
+// Bytes waiting for the transmit interrupt. Both indices only move under
+// tx_lock with interrupts off, the consumer's in the IRQ4 handler (or a
+// synchronous flush), so both can be free-running. The lock also keeps
+// polled output from several CPUs from interleaving mid-chunk.
+static char tx_ring[SERIAL_TX_SIZE];
+static volatile uint32_t tx_head = 0;
+static volatile uint32_t tx_tail = 0;
+static volatile bool tx_active = false;
+static bool tx_interrupts = false;
+static volatile uint32_t tx_dropped = 0;
+static lock_stats tx_lock_stats = LOCK_STATS_INIT("serial");
+static spinlock tx_lock = SPINLOCK_INIT_STATS(&tx_lock_stats);
+
 static inline void outb(uint16_t port, uint8_t val) {
     asm volatile("outb %0, %1" : : "a"(val), "Nd"(port));
 }
@@ -22,11 +53,17 @@ bool init_serial() {
     outb(SERIAL_PORT + 3, 0x03);
     outb(SERIAL_PORT + 2, 0xC7);
     outb(SERIAL_PORT + 4, 0x0B);
+
+    tx_head = 0;
+    tx_tail = 0;
+    tx_active = false;
+    tx_interrupts = false;
+    tx_dropped = 0;
     return true;
 }
 
 static bool is_transmit_empty() {
-    return inb(SERIAL_PORT + 5) & 0x20;
+    return inb(SERIAL_PORT + SERIAL_LSR) & SERIAL_LSR_THRE;
 }
 
 static void write_serial(char c) {
@@ -34,89 +71,109 @@ static void write_serial(char c) {
     outb(SERIAL_PORT, c);
 }
 
-void serial_write(const char* data) {
-    while (*data) {
+// Moves up to one FIFO's worth of queued bytes into the UART; the caller
+// has checked that the transmitter is empty
+static void drain_fifo() {
+    for (int i = 0; i < SERIAL_FIFO_SIZE && tx_tail != tx_head; i++) {
+        outb(SERIAL_PORT, tx_ring[tx_tail & SERIAL_TX_MASK]);
+        tx_tail++;
+    }
+}
+
+// Queues what fits and counts the rest as dropped. Starting the THR-empty
+// interrupt on an idle transmitter raises it at once, which sends the
+// first FIFO load.
+static void serial_enqueue(const char* data, size_t length) {
+    uint32_t flags = spin_lock_irqsave(&tx_lock);
+
+    size_t room = SERIAL_TX_SIZE - (tx_head - tx_tail);
+    if (length > room) {
+        tx_dropped += length - room;
+        length = room;
+    }
+    for (size_t i = 0; i < length; i++) {
+        tx_ring[tx_head & SERIAL_TX_MASK] = data[i];
+        tx_head++;
+    }
+
+    if (!tx_active && tx_head != tx_tail) {
+        tx_active = true;
+        outb(SERIAL_PORT + SERIAL_IER, SERIAL_IER_THRE);
+    }
+
+    spin_unlock_irqrestore(&tx_lock, flags);
+}
+
+static void serial_output(const char* data, size_t length) {
+    if (tx_interrupts) {
+        serial_enqueue(data, length);
+        return;
+    }
+
+    uint32_t flags = spin_lock_irqsave(&tx_lock);
+    while (length--) {
         write_serial(*data++);
     }
+    spin_unlock_irqrestore(&tx_lock, flags);
+}
+
+// IRQ4: refill the FIFO, or go quiet once the ring is empty
+static void serial_irq(interrupt_frame*) {
+    spin_lock_raw(&tx_lock);
+    // Reading IIR acknowledges a pending THR-empty interrupt
+    inb(SERIAL_PORT + SERIAL_IIR);
+
+    if (is_transmit_empty()) {
+        drain_fifo();
+    }
+
+    if (tx_tail == tx_head) {
+        tx_active = false;
+        outb(SERIAL_PORT + SERIAL_IER, 0x00);
+    }
+    spin_unlock_raw(&tx_lock);
+}
+
+void serial_enable_interrupts() {
+    tx_interrupts = register_irq_handler(4, serial_irq);
+}
+
+bool serial_flush() {
+    uint32_t flags = spin_lock_irqsave(&tx_lock);
+    bool queued = tx_interrupts;
+
+    outb(SERIAL_PORT + SERIAL_IER, 0x00);
+    tx_active = false;
+    tx_interrupts = false;
+
+    while (tx_tail != tx_head) {
+        write_serial(tx_ring[tx_tail & SERIAL_TX_MASK]);
+        tx_tail++;
+    }
+
+    spin_unlock_irqrestore(&tx_lock, flags);
+    return queued;
+}
+
+uint32_t serial_dropped() {
+    return tx_dropped;
+}
+
+void serial_write(const char* data) {
+    serial_output(data, strlen(data));
+}
+
+static void serial_sink(void*, const char* data, size_t length) {
+    serial_output(data, length);
+}
+
+void serial_vprintf(const char* format, va_list args) {
+    kvformat(serial_sink, nullptr, format, args);
 }
 
 void serial_printf(const char* format, ...) {
-    char buffer[256];
     va_list args;
     va_start(args, format);
-    
-    int i = 0;
-    while (*format && i < 255) {
-        if (*format == '%' && *(format + 1)) {
-            format++; // Skip '%'
-            switch (*format) {
-                case 's': {
-                    const char* str = va_arg(args, const char*);
-                    while (*str && i < 255) {
-                        buffer[i++] = *str++;
-                    }
-                    break;
-                }
-                case 'd': {
-                    int num = va_arg(args, int);
-                    char temp[16];
-                    int len = 0;
-                    if (num == 0) {
-                        temp[len++] = '0';
-                    } else {
-                        int tmp = num;
-                        while (tmp > 0 && len < 15) {
-                            temp[len++] = '0' + (tmp % 10);
-                            tmp /= 10;
-                        }
-                        // Reverse
-                        for (int j = 0; j < len / 2; j++) {
-                            char c = temp[j];
-                            temp[j] = temp[len - 1 - j];
-                            temp[len - 1 - j] = c;
-                        }
-                    }
-                    for (int j = 0; j < len && i < 255; j++) {
-                        buffer[i++] = temp[j];
-                    }
-                    break;
-                }
-                case 'x': {
-                    uint32_t num = va_arg(args, uint32_t);
-                    char temp[16];
-                    int len = 0;
-                    if (num == 0) {
-                        temp[len++] = '0';
-                    } else {
-                        while (num > 0 && len < 15) {
-                            int digit = num % 16;
-                            temp[len++] = digit < 10 ? '0' + digit : 'a' + digit - 10;
-                            num /= 16;
-                        }
-                        // Reverse
-                        for (int j = 0; j < len / 2; j++) {
-                            char c = temp[j];
-                            temp[j] = temp[len - 1 - j];
-                            temp[len - 1 - j] = c;
-                        }
-                    }
-                    for (int j = 0; j < len && i < 255; j++) {
-                        buffer[i++] = temp[j];
-                    }
-                    break;
-                }
-                default:
-                    buffer[i++] = '%';
-                    buffer[i++] = *format;
-                    break;
-            }
-            format++;
-        } else {
-            buffer[i++] = *format++;
-        }
-    }
-    buffer[i] = '\0';
-    
+    kvformat(serial_sink, nullptr, format, args);
     va_end(args);
-    serial_write(buffer);
-}
\ No newline at end of file
+}
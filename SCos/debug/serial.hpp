@@ -1,5 +1,19 @@
 #pragma once
 
+#include <stdint.h>
+#include <stdarg.h>
+
 bool init_serial();
 void serial_write(const char* data);
-void serial_printf(const char* format, ...);
\ No newline at end of file
+void serial_printf(const char* format, ...) __attribute__((format(printf, 1, 2)));
+void serial_vprintf(const char* format, va_list args) __attribute__((format(printf, 1, 0)));
+
+// Output is polled until this is called; afterwards writes are queued and
+// sent from the IRQ4 transmit interrupt. Call once interrupts are on.
+void serial_enable_interrupts();
+// Sends everything still queued with interrupts off and goes back to
+// polled output, for panics and bulk dumps. Returns whether output was
+// interrupt driven, so a dump can call serial_enable_interrupts() after.
+bool serial_flush();
+// Bytes discarded because the transmit ring was full
+uint32_t serial_dropped();
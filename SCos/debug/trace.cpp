@@ -0,0 +1,51 @@
+#include "trace.hpp"
+#include "serial.hpp"
+
+trace_record trace_ring[TRACE_RING_SIZE];
+volatile uint32_t trace_next = 0;
+volatile bool trace_active = false;
+
+// Indexed by trace_event; sent with each dump so the decoder needs no copy
+static const char* const trace_event_names[TRACE_EVENT_COUNT] = {
+    "none",
+    "keyboard_irq",
+    "desktop_events_begin",
+    "desktop_events_end",
+    "draw_window_begin",
+    "draw_window_end",
+    "kmalloc",
+    "kfree",
+};
+
+bool init_trace() {
+    trace_next = 0;
+    trace_active = true;
+    return true;
+}
+
+// Text framing keeps the dump readable among ordinary log lines; each
+// record is still one fixed-width line of raw hex
+void trace_dump() {
+    trace_active = false;
+
+    uint32_t end = trace_next;
+    uint32_t count = end < TRACE_RING_SIZE ? end : TRACE_RING_SIZE;
+    uint32_t start = end - count;
+
+    // A dump is far bigger than the transmit ring, so send it polled
+    bool queued = serial_flush();
+
+    serial_printf("TRACE START %u %u\n", count, end - count);
+    for (int i = 1; i < TRACE_EVENT_COUNT; i++) {
+        serial_printf("TRACE EVENT %d %s\n", i, trace_event_names[i]);
+    }
+    for (uint32_t i = start; i != end; i++) {
+        const trace_record* record = &trace_ring[i & (TRACE_RING_SIZE - 1)];
+        serial_printf("%08x%08x %x %x\n", (uint32_t)(record->tsc >> 32),
+                      (uint32_t)record->tsc, record->event, record->arg);
+    }
+    serial_printf("TRACE END\n");
+
+    if (queued) serial_enable_interrupts();
+    trace_active = true;
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <stdint.h>
+
+// Fixed-size binary event trace. Hot paths record {tsc, event, arg} with
+// TRACE() at the cost of an rdtsc and a few stores; nothing is formatted
+// until trace_dump() writes the ring to serial for debug/trace_decode.py.
+
+// Build with -DTRACE_ENABLED=0 to compile every TRACE() out
+#ifndef TRACE_ENABLED
+#define TRACE_ENABLED 1
+#endif
+
+// Records kept; a power of two so the claim index wraps with a mask
+#define TRACE_RING_SIZE 2048
+
+// Events ending in _BEGIN/_END are paired into durations by the decoder.
+// Keep trace_event_names in trace.cpp in the same order.
+enum trace_event {
+    TRACE_KEYBOARD_IRQ = 1,
+    TRACE_DESKTOP_EVENTS_BEGIN,
+    TRACE_DESKTOP_EVENTS_END,
+    TRACE_DRAW_WINDOW_BEGIN,
+    TRACE_DRAW_WINDOW_END,
+    TRACE_KMALLOC,
+    TRACE_KFREE,
+    TRACE_EVENT_COUNT
+};
+
+struct trace_record {
+    uint64_t tsc;
+    uint16_t event;
+    uint16_t reserved;
+    uint32_t arg;
+};
+
+extern trace_record trace_ring[TRACE_RING_SIZE];
+extern volatile uint32_t trace_next;
+extern volatile bool trace_active;
+
+static inline __attribute__((always_inline)) uint64_t trace_timestamp() {
+    uint32_t low, high;
+    asm volatile("rdtsc" : "=a"(low), "=d"(high));
+    return ((uint64_t)high << 32) | low;
+}
+
+// Claiming a slot is a single atomic add, so an interrupt handler can
+// record in the middle of another record without a lock. The oldest
+// records are overwritten once the ring wraps.
+static inline __attribute__((always_inline)) void trace_event_record(uint16_t event, uint32_t arg) {
+    if (!trace_active) return;
+
+    uint32_t slot = __atomic_fetch_add(&trace_next, 1, __ATOMIC_RELAXED) & (TRACE_RING_SIZE - 1);
+    trace_record* record = &trace_ring[slot];
+    record->tsc = trace_timestamp();
+    record->event = event;
+    record->arg = arg;
+}
+
+#if TRACE_ENABLED
+#define TRACE(event, arg) trace_event_record((event), (uint32_t)(arg))
+#else
+#define TRACE(event, arg) ((void)0)
+#endif
+
+bool init_trace();
+// Pauses recording, writes the ring oldest first, and resumes
+void trace_dump();
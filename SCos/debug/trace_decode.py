@@ -0,0 +1,100 @@
+#!/usr/bin/env python3
+"""Turns a trace_dump() from the serial log into a timeline.
+
+Usage: trace_decode.py [--mhz MHZ] [--summary] [LOG]
+
+Reads LOG (or stdin), takes the last TRACE START ... TRACE END block and
+prints one line per record with the time since the first record and since
+the previous one. Events named *_begin / *_end are paired per arg into
+durations. Times are in TSC cycles unless --mhz gives the TSC rate.
+"""
+
+import argparse
+import sys
+
+
+def read_dump(lines):
+    """Returns (names, records, lost) for the last complete dump."""
+    dump = None
+    result = None
+    for line in lines:
+        line = line.strip()
+        if line.startswith("TRACE START"):
+            fields = line.split()
+            dump = ({}, [], int(fields[3]) if len(fields) > 3 else 0)
+        elif dump is None:
+            continue
+        elif line == "TRACE END":
+            result, dump = dump, None
+        elif line.startswith("TRACE EVENT"):
+            _, _, event, name = line.split(None, 3)
+            dump[0][int(event)] = name
+        else:
+            fields = line.split()
+            if len(fields) != 3 or len(fields[0]) != 16:
+                continue  # ordinary log text interleaved with the dump
+            try:
+                dump[1].append(tuple(int(field, 16) for field in fields))
+            except ValueError:
+                continue
+    if result is None:
+        sys.exit("no complete TRACE START/END block found")
+    return result
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("log", nargs="?", help="serial log (default: stdin)")
+    parser.add_argument("--mhz", type=float, help="TSC rate, to print microseconds")
+    parser.add_argument("--summary", action="store_true", help="only print duration statistics")
+    args = parser.parse_args()
+
+    with open(args.log) if args.log else sys.stdin as source:
+        names, records, lost = read_dump(source)
+    if not records:
+        sys.exit("trace is empty")
+
+    unit = "us" if args.mhz else "cyc"
+
+    def scale(cycles):
+        return cycles / args.mhz if args.mhz else cycles
+
+    def fmt(cycles):
+        return f"{scale(cycles):12.3f}" if args.mhz else f"{cycles:12d}"
+
+    first = records[0][0]
+    previous = first
+    open_spans = {}
+    durations = {}
+
+    if not args.summary:
+        print(f"{'time (' + unit + ')':>12} {'delta':>12}  event")
+        if lost:
+            print(f"({lost} older records were overwritten)")
+
+    for tsc, event, arg in records:
+        name = names.get(event, f"event_{event}")
+
+        span = ""
+        if name.endswith("_begin"):
+            open_spans[(name[:-6], arg)] = tsc
+        elif name.endswith("_end"):
+            start = open_spans.pop((name[:-4], arg), None)
+            if start is not None:
+                durations.setdefault(name[:-4], []).append(tsc - start)
+                span = f"  [{fmt(tsc - start).strip()} {unit}]"
+
+        if not args.summary:
+            print(f"{fmt(tsc - first)} {fmt(tsc - previous)}  {name} {arg:#x}{span}")
+        previous = tsc
+
+    if durations:
+        print()
+        print(f"{'span':24} {'count':>7} {'min':>12} {'avg':>12} {'max':>12}  ({unit})")
+        for name, spans in sorted(durations.items()):
+            print(f"{name:24} {len(spans):7d} {fmt(min(spans))} "
+                  f"{fmt(sum(spans) // len(spans))} {fmt(max(spans))}")
+
+
+if __name__ == "__main__":
+    main()
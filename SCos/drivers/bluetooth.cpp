@@ -1,6 +1,7 @@
 
 #include "bluetooth.hpp"
-#include "../debug/serial.hpp"
+#include "../debug/log.hpp"
+#include "../include/kstring.hpp"
 
 // Static member definitions
 bool BluetoothDriver::bluetooth_enabled = false;
@@ -8,15 +9,6 @@ BluetoothDevice BluetoothDriver::connected_devices[8];
 int BluetoothDriver::device_count = 0;
 
 // Helper functions
-static void safe_strcpy(char* dest, const char* src, int max_len) {
-    int i = 0;
-    while (src[i] && i < max_len - 1) {
-        dest[i] = src[i];
-        i++;
-    }
-    dest[i] = '\0';
-}
-
 static void copy_address(uint8_t* dest, const uint8_t* src) {
     for (int i = 0; i < 6; i++) {
         dest[i] = src[i];
@@ -24,7 +16,7 @@ static void copy_address(uint8_t* dest, const uint8_t* src) {
 }
 
 void BluetoothDriver::init() {
-    serial_printf("Initializing Bluetooth driver...\n");
+    log_info(LOG_BLUETOOTH, "Initializing Bluetooth driver...\n");
     bluetooth_enabled = false;
     device_count = 0;
     
@@ -38,7 +30,7 @@ void BluetoothDriver::init() {
         }
     }
     
-    serial_printf("Bluetooth driver initialized\n");
+    log_info(LOG_BLUETOOTH, "Bluetooth driver initialized\n");
 }
 
 bool BluetoothDriver::isEnabled() {
@@ -46,24 +38,24 @@ bool BluetoothDriver::isEnabled() {
 }
 
 void BluetoothDriver::enable() {
-    serial_printf("Enabling Bluetooth...\n");
+    log_info(LOG_BLUETOOTH, "Enabling Bluetooth...\n");
     bluetooth_enabled = true;
-    serial_printf("Bluetooth enabled\n");
+    log_info(LOG_BLUETOOTH, "Bluetooth enabled\n");
 }
 
 void BluetoothDriver::disable() {
     if (bluetooth_enabled) {
-        serial_printf("Disabling Bluetooth...\n");
+        log_info(LOG_BLUETOOTH, "Disabling Bluetooth...\n");
         bluetooth_enabled = false;
         device_count = 0;
-        serial_printf("Bluetooth disabled\n");
+        log_info(LOG_BLUETOOTH, "Bluetooth disabled\n");
     }
 }
 
 int BluetoothDriver::scanDevices(BluetoothDevice* devices, int max_devices) {
     if (!bluetooth_enabled) return 0;
     
-    serial_printf("Scanning for Bluetooth devices...\n");
+    log_info(LOG_BLUETOOTH, "Scanning for Bluetooth devices...\n");
     
     // Mock some discovered devices
     const char* mock_names[] = {
@@ -84,30 +76,30 @@ int BluetoothDriver::scanDevices(BluetoothDevice* devices, int max_devices) {
     if (found_count > max_devices) found_count = max_devices;
     
     for (int i = 0; i < found_count; i++) {
-        safe_strcpy(devices[i].name, mock_names[i], 32);
+        str_copy(devices[i].name, sizeof(devices[i].name), mock_names[i]);
         copy_address(devices[i].address, mock_addresses[i]);
         devices[i].connected = false;
         devices[i].signal_strength = 75 - (i * 10); // Mock signal strength
     }
     
-    serial_printf("Found %d Bluetooth devices\n", found_count);
+    log_info(LOG_BLUETOOTH, "Found %d Bluetooth devices\n", found_count);
     return found_count;
 }
 
 bool BluetoothDriver::connectToDevice(const uint8_t* address) {
     if (!bluetooth_enabled) return false;
     
-    serial_printf("Connecting to Bluetooth device...\n");
+    log_info(LOG_BLUETOOTH, "Connecting to Bluetooth device...\n");
     
     // Mock successful connection
     if (device_count < 8) {
         copy_address(connected_devices[device_count].address, address);
-        safe_strcpy(connected_devices[device_count].name, "Connected Device", 32);
+        str_copy(connected_devices[device_count].name, sizeof(connected_devices[device_count].name), "Connected Device");
         connected_devices[device_count].connected = true;
         connected_devices[device_count].signal_strength = 80;
         device_count++;
         
-        serial_printf("Bluetooth device connected\n");
+        log_info(LOG_BLUETOOTH, "Bluetooth device connected\n");
         return true;
     }
     
@@ -125,7 +117,7 @@ void BluetoothDriver::disconnectDevice(const uint8_t* address) {
         }
         
         if (match) {
-            serial_printf("Disconnecting Bluetooth device: %s\n", connected_devices[i].name);
+            log_info(LOG_BLUETOOTH, "Disconnecting Bluetooth device: %s\n", connected_devices[i].name);
             
             // Shift devices down
             for (int k = i; k < device_count - 1; k++) {
@@ -151,7 +143,7 @@ int BluetoothDriver::sendData(const uint8_t* address, const uint8_t* data, int l
         }
         
         if (match && connected_devices[i].connected) {
-            serial_printf("Sending %d bytes via Bluetooth\n", length);
+            log_debug(LOG_BLUETOOTH, "Sending %d bytes via Bluetooth\n", length);
             return length; // Mock successful send
         }
     }
@@ -176,7 +168,7 @@ bool BluetoothDriver::isPaired(const uint8_t* address) {
 bool BluetoothDriver::pairDevice(const uint8_t* address, const char* pin) {
     if (!bluetooth_enabled) return false;
     
-    serial_printf("Pairing Bluetooth device with PIN: %s\n", pin);
+    log_debug(LOG_BLUETOOTH, "Pairing Bluetooth device with PIN: %s\n", pin);
     
     // Mock successful pairing
     return connectToDevice(address);
@@ -1,12 +1,19 @@
 #include <stdint.h>
 #include "keyboard.hpp"
-#include "../interrupt/idt.hpp"
-
-// Keyboard buffer
+#include "../interrupt/irq.hpp"
+#include "../interrupt/softirq.hpp"
+#include "../debug/trace.hpp"
+#include "../kernel/ring.hpp"
+#include "../kernel/percpu.hpp"
+#include "../include/kernel.h"
+
+// Translated keys from the softirq waiting for getKey
 #define KEYBOARD_BUFFER_SIZE 256
-static char keyboardBuffer[KEYBOARD_BUFFER_SIZE];
-static uint16_t bufferHead = 0;
-static uint16_t bufferTail = 0;
+static SpscRing<char, KEYBOARD_BUFFER_SIZE> keyboardBuffer;
+
+// Raw scancodes from IRQ1 waiting for the keyboard softirq
+#define SCANCODE_QUEUE_SIZE 64
+static SpscRing<uint8_t, SCANCODE_QUEUE_SIZE> scancodeQueue;
 
 // Modifier key states
 static bool shiftPressed = false;
@@ -56,27 +63,23 @@ static const char scancodeToAsciiShift[128] = {
 
 // Helper functions
 bool isKeyboardBufferEmpty() {
-    return bufferHead == bufferTail;
+    return keyboardBuffer.empty();
 }
 
 bool isKeyboardBufferFull() {
-    return ((bufferHead + 1) % KEYBOARD_BUFFER_SIZE) == bufferTail;
+    return keyboardBuffer.full();
 }
 
+// Keys typed while the buffer is full are dropped
 void addToKeyboardBuffer(char key) {
-    if (!isKeyboardBufferFull()) {
-        keyboardBuffer[bufferHead] = key;
-        bufferHead = (bufferHead + 1) % KEYBOARD_BUFFER_SIZE;
-    }
+    keyboardBuffer.push(key);
 }
 
 char getFromKeyboardBuffer() {
-    if (isKeyboardBufferEmpty()) {
+    char key;
+    if (!keyboardBuffer.pop(&key)) {
         return 0;
     }
-
-    char key = keyboardBuffer[bufferTail];
-    bufferTail = (bufferTail + 1) % KEYBOARD_BUFFER_SIZE;
     return key;
 }
 
@@ -126,9 +129,7 @@ char scancodeToChar(uint8_t scancode) {
     return ascii;
 }
 
-void handleKeyboardInterrupt() {
-    uint8_t scancode = inb(0x60);
-
+static void processScancode(uint8_t scancode) {
     // Check if this is a key release (bit 7 set)
     bool keyPressed = !(scancode & KEY_RELEASE);
     uint8_t actualScancode = scancode & 0x7F;
@@ -168,14 +169,36 @@ void handleKeyboardInterrupt() {
     }
 }
 
-extern "C" void keyboard_handler() {
+// Top half: take the byte off the controller and defer the translation
+void handleKeyboardInterrupt() {
+    uint8_t scancode = inb(0x60);
+    TRACE(TRACE_KEYBOARD_IRQ, scancode);
+
+    scancodeQueue.push(scancode);
+    raise_softirq(SOFTIRQ_KEYBOARD);
+}
+
+static void keyboard_irq(interrupt_frame*) {
     handleKeyboardInterrupt();
 }
 
+// Bottom half: everything queued since the last run, in one batch. This is
+// scancodeQueue's only consumer, which holds because softirqs run on the
+// BSP one pass at a time.
+static void keyboard_softirq() {
+    if (smp_cpu_id() != 0) kernel_panic("Keyboard softirq run off the BSP");
+
+    uint8_t scancodes[SCANCODE_QUEUE_SIZE];
+    uint32_t count = scancodeQueue.pop_bulk(scancodes, SCANCODE_QUEUE_SIZE);
+    for (uint32_t i = 0; i < count; i++) {
+        processScancode(scancodes[i]);
+    }
+}
+
 bool init_keyboard() {
-    // Initialize buffer pointers
-    bufferHead = 0;
-    bufferTail = 0;
+    // Drop anything queued before the handler was installed
+    keyboardBuffer.clear();
+    scancodeQueue.clear();
 
     // Initialize modifier key states
     shiftPressed = false;
@@ -183,12 +206,8 @@ bool init_keyboard() {
     altPressed = false;
     capsLock = false;
 
-    // Clear keyboard buffer
-    for (int i = 0; i < KEYBOARD_BUFFER_SIZE; i++) {
-        keyboardBuffer[i] = 0;
-    }
-
-    return true;
+    register_softirq(SOFTIRQ_KEYBOARD, keyboard_softirq);
+    return register_irq_handler(1, keyboard_irq);
 }
 
 // Public API functions
@@ -201,7 +220,7 @@ bool hasKey() {
 }
 
 void clearKeyboardBuffer() {
-    bufferHead = bufferTail = 0;
+    keyboardBuffer.clear();
 }
 
 // Modifier key state queries
@@ -223,10 +242,13 @@ bool isCapsLockOn() {
 
 // Wait for a key press (blocking)
 char waitForKey() {
+    // Keys only reach the buffer through the softirq, so run it here too
+    run_softirqs();
     while (isKeyboardBufferEmpty()) {
         // You might want to call a halt instruction here
         // or yield to other processes in a multitasking environment
         asm volatile("hlt");
+        run_softirqs();
     }
     return getFromKeyboardBuffer();
 }
@@ -10,7 +10,6 @@
 #define KEY_ENTER 0x1C
 #define KEY_BACKSPACE 0x0E
 
-extern "C" void keyboard_handler();
 bool init_keyboard();
 char readScancode();
 
@@ -18,8 +17,6 @@ char getKey();
 bool hasKey();
 void handleKeyboardInterrupt();
 
-extern "C" void keyboard_handler();
-
 char getKey();
 bool hasKey();
 void clearKeyboardBuffer();
@@ -1,25 +1,17 @@
 #include "network.hpp"
-#include "../debug/serial.hpp"
+#include "../debug/log.hpp"
+#include "../include/kstring.hpp"
 
 bool NetworkDriver::wifi_connected = false;
 char NetworkDriver::ip_address[16] = "192.168.1.100";
 char NetworkDriver::ssid[32] = "";
 
-static void safe_strcpy(char* dest, const char* src, int max_len) {
-    int i = 0;
-    while (src[i] && i < max_len - 1) {
-        dest[i] = src[i];
-        i++;
-    }
-    dest[i] = '\0';
-}
-
 void NetworkDriver::init() {
-    serial_printf("Initializing network driver...\n");
+    log_info(LOG_NETWORK, "Initializing network driver...\n");
     wifi_connected = false;
     ip_address[0] = '\0';
     ssid[0] = '\0';
-    serial_printf("Network driver initialized\n");
+    log_info(LOG_NETWORK, "Network driver initialized\n");
 }
 
 bool NetworkDriver::isConnected() {
@@ -27,20 +19,20 @@ bool NetworkDriver::isConnected() {
 }
 
 bool NetworkDriver::connectToWifi(const char* network_ssid, const char* password) {
-    serial_printf("Connecting to WiFi: %s\n", network_ssid);
+    log_info(LOG_NETWORK, "Connecting to WiFi: %s\n", network_ssid);
     
-    safe_strcpy(ssid, network_ssid, 32);
+    str_copy(ssid, sizeof(ssid), network_ssid);
     
     wifi_connected = true;
-    safe_strcpy(ip_address, "192.168.1.100", 16);
+    str_copy(ip_address, sizeof(ip_address), "192.168.1.100");
     
-    serial_printf("Connected to %s with IP %s\n", ssid, ip_address);
+    log_info(LOG_NETWORK, "Connected to %s with IP %s\n", ssid, ip_address);
     return true;
 }
 
 void NetworkDriver::disconnect() {
     if (wifi_connected) {
-        serial_printf("Disconnecting from %s\n", ssid);
+        log_info(LOG_NETWORK, "Disconnecting from %s\n", ssid);
         wifi_connected = false;
         ssid[0] = '\0';
         ip_address[0] = '\0';
@@ -50,7 +42,7 @@ void NetworkDriver::disconnect() {
 int NetworkDriver::sendData(const uint8_t* data, int length) {
     if (!wifi_connected) return -1;
     
-    serial_printf("Sending %d bytes\n", length);
+    log_debug(LOG_NETWORK, "Sending %d bytes\n", length);
     return length;
 }
 
@@ -73,5 +65,5 @@ const char* NetworkDriver::getIPAddress() {
 }
 
 void NetworkDriver::setDHCP(bool enabled) {
-    serial_printf("DHCP %s\n", enabled ? "enabled" : "disabled");
+    log_info(LOG_NETWORK, "DHCP %s\n", enabled ? "enabled" : "disabled");
 }
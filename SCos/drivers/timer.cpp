@@ -0,0 +1,239 @@
+#include "timer.hpp"
+#include "../include/io_utils.h"
+#include "../include/div64.h"
+#include "../interrupt/irq.hpp"
+#include "../kernel/ktimer.hpp"
+#include "../kernel/thread.hpp"
+#include "../kernel/percpu.hpp"
+#include "../kernel/seqlock.hpp"
+
+#define PIT_FREQUENCY 1193182
+#define PIT_CHANNEL0 0x40
+#define PIT_CHANNEL2 0x42
+#define PIT_COMMAND 0x43
+// Port B: bit 0 gates channel 2, bit 1 drives the speaker, bit 5 is OUT2
+#define PIT_PORT_B 0x61
+
+#define CALIBRATION_MS 10
+// ns = cycles * ns_per_cycle, with ns_per_cycle in 8.24 fixed point
+#define NS_SHIFT 24
+
+#define CMOS_INDEX 0x70
+#define CMOS_DATA 0x71
+
+static uint32_t tick_rate = 0;
+static uint16_t pit_divisor = 0;
+static volatile uint64_t ticks = 0;
+static uint32_t ns_per_tick = 0;
+
+static uint64_t tsc_base = 0;
+static uint32_t tsc_rate_khz = 0;
+static uint32_t ns_per_cycle = 0;
+
+// The cached wall-clock time is read from every CPU. A refresh reads the
+// RTC under cmos_lock, since the index and data ports are one shared
+// pair, and publishes the result under clock_lock.
+static clock_time cached_clock;
+static uint32_t cached_clock_ms = 0;
+static bool cached_clock_valid = false;
+static lock_stats clock_lock_stats = LOCK_STATS_INIT("clock");
+static seqlock clock_lock = SEQLOCK_INIT_STATS(&clock_lock_stats);
+static spinlock cmos_lock = SPINLOCK_INIT;
+
+static inline uint64_t read_tsc() {
+    uint32_t low, high;
+    asm volatile("rdtsc" : "=a"(low), "=d"(high));
+    return ((uint64_t)high << 32) | low;
+}
+
+// Counts TSC cycles across a one-shot PIT channel 2 countdown; returns the
+// TSC rate in kHz, or 0 if the TSC did not move
+static uint32_t calibrate_tsc() {
+    uint8_t port_b = inb(PIT_PORT_B);
+    outb(PIT_PORT_B, (port_b & ~0x02) | 0x01);
+
+    uint16_t count = PIT_FREQUENCY * CALIBRATION_MS / 1000;
+    outb(PIT_COMMAND, 0xB0); // channel 2, lobyte/hibyte, mode 0
+    outb(PIT_CHANNEL2, count & 0xFF);
+    outb(PIT_CHANNEL2, count >> 8);
+
+    uint64_t start = read_tsc();
+    while (!(inb(PIT_PORT_B) & 0x20));
+    uint64_t end = read_tsc();
+
+    outb(PIT_PORT_B, port_b);
+    return (uint32_t)div64_32(end - start, CALIBRATION_MS);
+}
+
+// Channel 0 raises IRQ0 as it reloads, so the count it has run down since
+// dates the interrupt. An IRQ0 held off past the next reload reads short.
+static uint32_t pit_irq_age() {
+    outb(PIT_COMMAND, 0x00); // latch channel 0
+    uint8_t low = inb(PIT_CHANNEL0);
+    uint8_t high = inb(PIT_CHANNEL0);
+    uint32_t elapsed = pit_divisor - ((high << 8) | low);
+    return (uint32_t)div64_32((uint64_t)elapsed * tsc_rate_khz * 1000, PIT_FREQUENCY);
+}
+
+static void timer_irq(interrupt_frame*) {
+    ticks++;
+    ktimer_tick();
+    thread_tick();
+}
+
+bool init_timer(uint32_t hz) {
+    if (hz == 0 || PIT_FREQUENCY / hz == 0 || PIT_FREQUENCY / hz > 0xFFFF) {
+        return false;
+    }
+
+    tsc_rate_khz = calibrate_tsc();
+    if (tsc_rate_khz) {
+        uint64_t scaled = div64_32((uint64_t)1000000 << NS_SHIFT, tsc_rate_khz);
+        // A TSC below ~4 MHz cannot use the fixed-point path
+        ns_per_cycle = scaled >> 32 ? 0 : (uint32_t)scaled;
+    }
+
+    pit_divisor = PIT_FREQUENCY / hz;
+    outb(PIT_COMMAND, 0x34); // channel 0, lobyte/hibyte, rate generator
+    outb(PIT_CHANNEL0, pit_divisor & 0xFF);
+    outb(PIT_CHANNEL0, pit_divisor >> 8);
+
+    tick_rate = hz;
+    ns_per_tick = 1000000000u / hz;
+    ticks = 0;
+    tsc_base = read_tsc();
+    cached_clock_valid = false;
+    if (tsc_rate_khz) {
+        set_irq_age_source(0, pit_irq_age);
+    }
+    return register_irq_handler(0, timer_irq);
+}
+
+uint64_t ktime_ticks() {
+    // A 64-bit load is two 32-bit loads here; retry if IRQ0 split them
+    uint64_t first, second;
+    do {
+        first = ticks;
+        second = ticks;
+    } while (first != second);
+    return first;
+}
+
+uint64_t ktime_ns() {
+    if (!ns_per_cycle) {
+        return ktime_ticks() * ns_per_tick;
+    }
+
+    uint64_t cycles = read_tsc() - tsc_base;
+    uint32_t high = cycles >> 32;
+    uint32_t low = (uint32_t)cycles;
+    return (((uint64_t)low * ns_per_cycle) >> NS_SHIFT) +
+           (((uint64_t)high * ns_per_cycle) << (32 - NS_SHIFT));
+}
+
+uint32_t ktime_ms() {
+    return (uint32_t)div64_32(ktime_ns(), 1000000);
+}
+
+uint32_t timer_hz() {
+    return tick_rate;
+}
+
+uint32_t tsc_khz() {
+    return tsc_rate_khz;
+}
+
+uint64_t ktime_deadline_ms(uint32_t ms) {
+    return ktime_ns() + (uint64_t)ms * 1000000;
+}
+
+bool ktime_expired(uint64_t deadline) {
+    return ktime_ns() >= deadline;
+}
+
+void ksleep_until(uint64_t deadline) {
+    if (thread_can_sleep()) {
+        thread_sleep_until(deadline);
+        return;
+    }
+
+    // APs get no timer interrupt to end a hlt
+    while (!ktime_expired(deadline)) {
+        if (interrupts_enabled() && smp_cpu_id() == 0) {
+            asm volatile("hlt");
+        } else {
+            asm volatile("pause");
+        }
+    }
+}
+
+void ksleep_ms(uint32_t ms) {
+    ksleep_until(ktime_deadline_ms(ms));
+}
+
+static uint8_t cmos_read(uint8_t reg) {
+    outb(CMOS_INDEX, reg);
+    return inb(CMOS_DATA);
+}
+
+static int from_bcd(uint8_t value) {
+    return (value >> 4) * 10 + (value & 0x0F);
+}
+
+static void rtc_read(clock_time* time) {
+    // Registers are inconsistent while the RTC is updating them
+    while (cmos_read(0x0A) & 0x80);
+
+    uint8_t second = cmos_read(0x00);
+    uint8_t minute = cmos_read(0x02);
+    uint8_t hour = cmos_read(0x04);
+    uint8_t day = cmos_read(0x07);
+    uint8_t month = cmos_read(0x08);
+    uint8_t year = cmos_read(0x09);
+    uint8_t status_b = cmos_read(0x0B);
+
+    bool pm = hour & 0x80;
+    hour &= 0x7F;
+    if (!(status_b & 0x04)) {
+        second = from_bcd(second);
+        minute = from_bcd(minute);
+        hour = from_bcd(hour);
+        day = from_bcd(day);
+        month = from_bcd(month);
+        year = from_bcd(year);
+    }
+    if (!(status_b & 0x02)) {
+        // 12-hour mode: 12 AM is midnight, 12 PM is noon
+        hour = hour % 12 + (pm ? 12 : 0);
+    }
+
+    time->year = 2000 + year;
+    time->month = month;
+    time->day = day;
+    time->hour = hour;
+    time->minute = minute;
+    time->second = second;
+}
+
+void clock_read(clock_time* time) {
+    uint32_t now = ktime_ms();
+    uint32_t sequence;
+    bool stale;
+    do {
+        sequence = read_seqbegin(&clock_lock);
+        stale = !cached_clock_valid || now - cached_clock_ms >= 1000;
+        *time = cached_clock;
+    } while (read_seqretry(&clock_lock, sequence));
+    if (!stale) return;
+
+    // Readers never wait on the RTC, which can take a whole update cycle
+    spin_lock(&cmos_lock);
+    rtc_read(time);
+    spin_unlock(&cmos_lock);
+
+    write_seqlock(&clock_lock);
+    cached_clock = *time;
+    cached_clock_ms = now;
+    cached_clock_valid = true;
+    write_sequnlock(&clock_lock);
+}
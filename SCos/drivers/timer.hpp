@@ -0,0 +1,45 @@
+#ifndef TIMER_HPP
+#define TIMER_HPP
+
+#include <stdint.h>
+
+// PIT channel 0 tick rate used at boot; init_timer accepts any rate the
+// 16-bit divisor can express (19 Hz and up)
+#define TIMER_HZ 1000
+
+struct clock_time {
+    int year;
+    int month;
+    int day;
+    int hour;
+    int minute;
+    int second;
+};
+
+// Calibrates the TSC against PIT channel 2, programs channel 0 to
+// interrupt at `hz` and takes IRQ0, so it runs after init_idt.
+bool init_timer(uint32_t hz);
+
+// Monotonic time since init_timer. ktime_ns has TSC resolution; ticks
+// count IRQ0 interrupts and so only advance while interrupts are on.
+uint64_t ktime_ns();
+uint64_t ktime_ticks();
+uint32_t ktime_ms();
+uint32_t timer_hz();
+uint32_t tsc_khz();
+
+// Deadlines are absolute ktime_ns values
+uint64_t ktime_deadline_ms(uint32_t ms);
+bool ktime_expired(uint64_t deadline);
+
+// Blocks the calling thread until the deadline passes, letting others
+// run. Before the scheduler is up it halts between timer interrupts, and
+// with interrupts off it spins, since there is nothing to wake on.
+void ksleep_until(uint64_t deadline);
+void ksleep_ms(uint32_t ms);
+
+// Wall-clock time from the CMOS real-time clock, re-read at most once a
+// second
+void clock_read(clock_time* time);
+
+#endif
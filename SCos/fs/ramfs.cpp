@@ -1,26 +1,6 @@
 #include "ramfs.hpp"
 #include <stdint.h>
-
-static int custom_strlen(const char* str) {
-    int len = 0;
-    while (str[len]) len++;
-    return len;
-}
-
-static int custom_strcmp(const char* str1, const char* str2) {
-    while (*str1 && (*str1 == *str2)) {
-        str1++;
-        str2++;
-    }
-    return *(unsigned char*)str1 - *(unsigned char*)str2;
-}
-
-static void custom_strcpy(char* dest, const char* src) {
-    while (*src) {
-        *dest++ = *src++;
-    }
-    *dest = '\0';
-}
+#include "../include/kstring.hpp"
 
 struct File {
     char path[256];
@@ -62,7 +42,7 @@ const char* readFile(const char* path) {
     }
     
     for (int i = 0; i < MAX_FILES; i++) {
-        if (files[i].in_use && custom_strcmp(files[i].path, path) == 0) {
+        if (files[i].in_use && strcmp(files[i].path, path) == 0) {
             return files[i].content;
         }
     }
@@ -80,14 +60,8 @@ bool writeFile(const char* path, const char* data) {
     }
     
     for (int i = 0; i < MAX_FILES; i++) {
-        if (files[i].in_use && custom_strcmp(files[i].path, path) == 0) {
-            int len = custom_strlen(data);
-            if (len >= 1024) len = 1023;
-            
-            for (int j = 0; j < len; j++) {
-                files[i].content[j] = data[j];
-            }
-            files[i].content[len] = '\0';
+        if (files[i].in_use && strcmp(files[i].path, path) == 0) {
+            str_copy(files[i].content, sizeof(files[i].content), data);
             return true;
         }
     }
@@ -97,19 +71,8 @@ bool writeFile(const char* path, const char* data) {
             if (!files[i].in_use) {
                 files[i].in_use = true;
                 
-                int path_len = custom_strlen(path);
-                if (path_len >= 256) path_len = 255;
-                for (int j = 0; j < path_len; j++) {
-                    files[i].path[j] = path[j];
-                }
-                files[i].path[path_len] = '\0';
-                
-                int data_len = custom_strlen(data);
-                if (data_len >= 1024) data_len = 1023;
-                for (int j = 0; j < data_len; j++) {
-                    files[i].content[j] = data[j];
-                }
-                files[i].content[data_len] = '\0';
+                str_copy(files[i].path, sizeof(files[i].path), path);
+                str_copy(files[i].content, sizeof(files[i].content), data);
                 
                 fileCount++;
                 return true;
@@ -126,7 +89,7 @@ bool deleteFile(const char* path) {
     }
     
     for (int i = 0; i < MAX_FILES; i++) {
-        if (files[i].in_use && custom_strcmp(files[i].path, path) == 0) {
+        if (files[i].in_use && strcmp(files[i].path, path) == 0) {
             files[i].in_use = false;
             files[i].path[0] = '\0';
             files[i].content[0] = '\0';
@@ -144,7 +107,7 @@ bool fileExists(const char* path) {
     }
     
     for (int i = 0; i < MAX_FILES; i++) {
-        if (files[i].in_use && custom_strcmp(files[i].path, path) == 0) {
+        if (files[i].in_use && strcmp(files[i].path, path) == 0) {
             return true;
         }
     }
@@ -0,0 +1,18 @@
+#ifndef DIV64_H
+#define DIV64_H
+
+#include <stdint.h>
+
+// 64-bit by 32-bit division without libgcc: the high word first, then the
+// remainder and low word with one divl, which cannot overflow
+static inline uint64_t div64_32(uint64_t dividend, uint32_t divisor) {
+    uint32_t high = dividend >> 32;
+    uint32_t low = (uint32_t)dividend;
+    uint32_t quotient_high = high / divisor;
+    uint32_t remainder = high % divisor;
+    uint32_t quotient_low;
+    asm("divl %2" : "=a"(quotient_low), "+d"(remainder) : "rm"(divisor), "a"(low));
+    return ((uint64_t)quotient_high << 32) | quotient_low;
+}
+
+#endif
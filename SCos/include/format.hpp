@@ -0,0 +1,23 @@
+#ifndef FORMAT_HPP
+#define FORMAT_HPP
+
+#include "stddef.h"
+#include "stdarg.h"
+
+// Kernel printf engine. Output goes straight to a sink in pieces (literal
+// runs, padding, converted fields), so serial, VGA and buffer writers share
+// one formatter and none of them needs a staging buffer.
+//
+// Conversions: %d %i %u %x %X %p %s %c %%
+// Flags: '-' left-justify, '0' zero-pad; width and %s precision may be '*'.
+// 'l' and 'z' length modifiers are accepted; both are 32 bits here.
+
+// Receives one piece of output; `data` is not NUL-terminated
+typedef void (*format_sink)(void* context, const char* data, size_t length);
+
+// Both return the number of characters produced
+int kvformat(format_sink sink, void* context, const char* format, va_list args);
+int kformat(format_sink sink, void* context, const char* format, ...)
+    __attribute__((format(printf, 3, 4)));
+
+#endif
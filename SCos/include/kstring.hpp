@@ -0,0 +1,125 @@
+#ifndef KSTRING_HPP
+#define KSTRING_HPP
+
+#include "stddef.h"
+#include "string.hpp"
+
+// Shared kernel string toolkit on top of lib/string.cpp. Strings carry
+// their length in a StrView, and the bounded copy/append helpers return the
+// new length, so callers building a buffer piece by piece never rescan it.
+
+struct StrView {
+    const char* data;
+    size_t length;
+
+    StrView() : data(""), length(0) {}
+    StrView(const char* str) : data(str), length(strlen(str)) {}
+    StrView(const char* str, size_t len) : data(str), length(len) {}
+
+    bool empty() const { return length == 0; }
+    char operator[](size_t index) const { return data[index]; }
+
+    bool equals(StrView other) const {
+        return length == other.length && memcmp(data, other.data, length) == 0;
+    }
+
+    bool starts_with(StrView prefix) const {
+        return length >= prefix.length && memcmp(data, prefix.data, prefix.length) == 0;
+    }
+
+    bool ends_with(StrView suffix) const {
+        return length >= suffix.length &&
+               memcmp(data + length - suffix.length, suffix.data, suffix.length) == 0;
+    }
+
+    StrView substr(size_t start, size_t count = (size_t)-1) const {
+        if (start > length) start = length;
+        if (count > length - start) count = length - start;
+        return StrView(data + start, count);
+    }
+
+    // Index of the first occurrence, or -1
+    int find(char c) const {
+        for (size_t i = 0; i < length; i++) {
+            if (data[i] == c) return (int)i;
+        }
+        return -1;
+    }
+
+    // Scans for the needle's first byte and only compares from there
+    int find(StrView needle) const {
+        if (needle.length == 0) return 0;
+        if (needle.length > length) return -1;
+
+        size_t last = length - needle.length;
+        char first = needle.data[0];
+        for (size_t i = 0; i <= last; i++) {
+            if (data[i] == first && memcmp(data + i + 1, needle.data + 1, needle.length - 1) == 0) {
+                return (int)i;
+            }
+        }
+        return -1;
+    }
+
+    bool contains(StrView needle) const { return find(needle) >= 0; }
+
+    StrView trim() const {
+        size_t start = 0;
+        size_t end = length;
+        while (start < end && is_space(data[start])) start++;
+        while (end > start && is_space(data[end - 1])) end--;
+        return StrView(data + start, end - start);
+    }
+
+    static bool is_space(char c) {
+        return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+    }
+};
+
+// Copies as much of `src` as fits in `capacity` bytes including the
+// terminator; returns the resulting length
+inline size_t str_copy(char* dest, size_t capacity, StrView src) {
+    if (capacity == 0) return 0;
+    size_t count = src.length < capacity - 1 ? src.length : capacity - 1;
+    memcpy(dest, src.data, count);
+    dest[count] = '\0';
+    return count;
+}
+
+// Appends `src` to a string of known `length`; returns the new length
+inline size_t str_append(char* dest, size_t capacity, size_t length, StrView src) {
+    if (length >= capacity) return length;
+    return length + str_copy(dest + length, capacity - length, src);
+}
+
+// Appends the decimal form of `value`; returns the new length
+inline size_t str_append_int(char* dest, size_t capacity, size_t length, int value) {
+    char digits[12];
+    int count = 0;
+    uint32_t magnitude = value < 0 ? 0u - (uint32_t)value : (uint32_t)value;
+    do {
+        digits[sizeof(digits) - 1 - count++] = '0' + magnitude % 10;
+        magnitude /= 10;
+    } while (magnitude);
+    if (value < 0) digits[sizeof(digits) - 1 - count++] = '-';
+    return str_append(dest, capacity, length, StrView(digits + sizeof(digits) - count, count));
+}
+
+// Leading optional sign and decimal digits; stops at the first non-digit
+inline int str_to_int(StrView str) {
+    size_t i = 0;
+    int sign = 1;
+    if (i < str.length && (str[i] == '-' || str[i] == '+')) {
+        if (str[i] == '-') sign = -1;
+        i++;
+    }
+
+    int result = 0;
+    while (i < str.length && str[i] >= '0' && str[i] <= '9') {
+        result = result * 10 + (str[i] - '0');
+        i++;
+    }
+    return sign * result;
+}
+
+#endif
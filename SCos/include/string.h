@@ -3,6 +3,7 @@
 #define STRING_H
 
 #include <stddef.h>
+#include <stdarg.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -16,7 +17,11 @@ char* strncpy(char* dest, const char* src, size_t n);
 char* strcat(char* dest, const char* src);
 char* strstr(const char* haystack, const char* needle);
 char* strrchr(const char* str, int c);
-int snprintf(char* buffer, size_t size, const char* format, ...);
+// Formatting lives in lib/format.cpp; see format.hpp for the conversions
+int snprintf(char* buffer, size_t size, const char* format, ...)
+    __attribute__((format(printf, 3, 4)));
+int vsnprintf(char* buffer, size_t size, const char* format, va_list args)
+    __attribute__((format(printf, 3, 0)));
 int sscanf(const char* str, const char* format, ...);
 
 #ifdef __cplusplus
@@ -1,7 +1,7 @@
 global idt_load
-global keyboard_interrupt_wrapper
+global interrupt_stubs
 
-extern keyboard_handler
+extern interrupt_dispatch
 
 idt_load:
     mov eax, [esp+4]
@@ -9,11 +9,36 @@ idt_load:
     ret
 
 
-keyboard_interrupt_wrapper:
-    pusha                    
-    call keyboard_handler   
-    
-    mov al, 0x20
-    out 0x20, al
-    popa                     
-    iret                     
+; One stub per vector. Each leaves the same frame for interrupt_dispatch:
+; a dummy error code where the CPU pushes none, then the vector number.
+%assign i 0
+%rep 256
+isr_stub_%+i:
+%if !(i == 8 || (i >= 10 && i <= 14) || i == 17 || i == 21 || i == 29 || i == 30)
+    push dword 0
+%endif
+    push dword i
+    jmp interrupt_common
+%assign i i+1
+%endrep
+
+
+interrupt_common:
+    pusha
+    cld
+    push esp                 ; interrupt_frame*
+    call interrupt_dispatch
+    add esp, 4
+    popa
+    add esp, 8               ; drop the vector and error code
+    iret
+
+
+section .rodata
+
+interrupt_stubs:
+%assign i 0
+%rep 256
+    dd isr_stub_%+i
+%assign i i+1
+%endrep
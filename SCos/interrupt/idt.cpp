@@ -1,12 +1,12 @@
 #include "idt.hpp"
-#include "../debug/serial.hpp"
+#include "../debug/log.hpp"
 
 static idt_entry idt[256];
 static idt_ptr idtp;
 
 extern "C" void idt_load(uint32_t);
-extern "C" void keyboard_interrupt_wrapper();
-extern "C" void keyboard_handler();
+// Entry points generated in idt.asm, one per vector
+extern "C" const uint32_t interrupt_stubs[256];
 
 void set_idt_gate(int n, uint32_t handler) {
     idt[n].offset_low = handler & 0xFFFF;
@@ -64,27 +64,27 @@ void disable_irq(uint8_t irq) {
 }
 
 bool init_idt() {
-    serial_printf("IDT initialization started\n");
+    log_debug(LOG_INTERRUPT, "IDT initialization started\n");
     
     idtp.limit = (sizeof(idt_entry) * 256) - 1;
     idtp.base = (uint32_t)&idt;
     
+    // Every vector gets a gate, so a stray interrupt reaches the
+    // dispatcher instead of triple-faulting
     for (int i = 0; i < 256; i++) {
-        idt[i].offset_low = 0;
-        idt[i].selector = 0;
-        idt[i].zero = 0;
-        idt[i].type_attr = 0;
-        idt[i].offset_high = 0;
+        set_idt_gate(i, interrupt_stubs[i]);
     }
     
+    // All lines start masked; register_irq_handler unmasks them
     init_pic();
     
-    set_idt_gate(33, (uint32_t)keyboard_interrupt_wrapper);
-    
     idt_load((uint32_t)&idtp);
     
-    enable_irq(1);
-    
-    serial_printf("IDT initialization completed\n");
+    log_debug(LOG_INTERRUPT, "IDT initialization completed\n");
     return true;
 }
+
+// APs share the BSP's table
+void idt_reload() {
+    idt_load((uint32_t)&idtp);
+}
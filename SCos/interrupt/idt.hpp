@@ -20,6 +20,8 @@ struct idt_ptr {
 
 
 bool init_idt();
+// Loads the table init_idt built on the calling CPU
+void idt_reload();
 void set_idt_gate(int n, uint32_t handler);
 
 
@@ -28,9 +30,4 @@ void enable_irq(uint8_t irq);
 void disable_irq(uint8_t irq);
 
 
-
-
-extern "C" void keyboard_interrupt_wrapper();
-extern "C" void keyboard_handler();
-
 #endif 
@@ -0,0 +1,246 @@
+#include "irq.hpp"
+#include "idt.hpp"
+#include "../debug/log.hpp"
+#include "../debug/serial.hpp"
+#include "../include/kernel.h"
+#include "../kernel/thread.hpp"
+#include "../kernel/percpu.hpp"
+
+#define PIC1_COMMAND 0x20
+#define PIC2_COMMAND 0xA0
+#define PIC_EOI 0x20
+#define PIC_READ_ISR 0x0B
+#define PIC_CASCADE_IRQ 2
+
+static interrupt_handler handlers[256];
+static uint32_t counts[256];
+static uint32_t spurious = 0;
+
+static irq_age_source age_sources[IRQ_LINES];
+static irq_histogram latency[IRQ_LINES];
+static irq_histogram duration[IRQ_LINES];
+
+static irq_histogram off_histogram;
+static uint32_t off_start = 0;
+static uint32_t off_site = 0;
+static bool off_open = false;
+static uint32_t longest_off = 0;
+static uint32_t longest_off_site = 0;
+
+static const char* const exception_names[32] = {
+    "Divide error", "Debug", "NMI", "Breakpoint",
+    "Overflow", "Bound range exceeded", "Invalid opcode", "Device not available",
+    "Double fault", "Coprocessor segment overrun", "Invalid TSS", "Segment not present",
+    "Stack fault", "General protection fault", "Page fault", "Reserved",
+    "x87 floating point", "Alignment check", "Machine check", "SIMD floating point",
+    "Virtualization", "Control protection", "Reserved", "Reserved",
+    "Reserved", "Reserved", "Reserved", "Reserved",
+    "Hypervisor injection", "VMM communication", "Security", "Reserved"
+};
+
+static void pic_eoi(uint8_t irq) {
+    if (irq >= 8) {
+        outb(PIC2_COMMAND, PIC_EOI);
+    }
+    outb(PIC1_COMMAND, PIC_EOI);
+}
+
+// IRQ7 and IRQ15 are what a PIC raises when a request vanishes before it
+// is acknowledged; a real one has its in-service bit set
+static bool pic_spurious(uint8_t irq) {
+    if (irq != 7 && irq != 15) return false;
+
+    uint16_t port = irq == 7 ? PIC1_COMMAND : PIC2_COMMAND;
+    outb(port, PIC_READ_ISR);
+    return !(inb(port) & 0x80);
+}
+
+static void histogram_add(irq_histogram* histogram, uint32_t cycles) {
+    histogram->count++;
+    if (cycles > histogram->max) histogram->max = cycles;
+    histogram->buckets[cycles ? 31 - __builtin_clz(cycles) : 0]++;
+}
+
+static void handle_irq(interrupt_frame* frame, uint32_t entry) {
+    uint8_t irq = frame->vector - IRQ_BASE;
+
+    if (pic_spurious(irq)) {
+        spurious++;
+        // The master did see a real request on its cascade line
+        if (irq == 15) pic_eoi(0);
+        return;
+    }
+
+#if IRQ_STATS
+    uint32_t raised = entry;
+    if (age_sources[irq]) {
+        uint32_t age = age_sources[irq]();
+        raised = irq_cycles() - age;
+    }
+    uint32_t start = irq_cycles();
+#endif
+
+    if (handlers[frame->vector]) {
+        handlers[frame->vector](frame);
+    }
+
+#if IRQ_STATS
+    uint32_t end = irq_cycles();
+    histogram_add(&latency[irq], start - raised);
+    histogram_add(&duration[irq], end - start);
+#endif
+
+    pic_eoi(irq);
+    thread_irq_exit();
+}
+
+extern "C" void interrupt_dispatch(interrupt_frame* frame) {
+    uint32_t entry = IRQ_STATS ? irq_cycles() : 0;
+    uint32_t vector = frame->vector;
+    counts[vector]++;
+
+    if (vector >= IRQ_BASE && vector < IRQ_BASE + IRQ_LINES) {
+        handle_irq(frame, entry);
+        return;
+    }
+
+    if (handlers[vector]) {
+        handlers[vector](frame);
+        return;
+    }
+
+    if (vector < 32) {
+        log_error(LOG_INTERRUPT, "%s at 0x%x, error code 0x%x\n",
+                  exception_names[vector], frame->eip, frame->error_code);
+        kernel_panic(exception_names[vector]);
+    }
+
+    log_warn(LOG_INTERRUPT, "Unexpected interrupt %u\n", vector);
+}
+
+bool register_irq_handler(uint8_t irq, interrupt_handler handler) {
+    if (irq >= IRQ_LINES || !handler) return false;
+
+    uint32_t flags = irq_save();
+    interrupt_handler current = handlers[IRQ_BASE + irq];
+    bool registered = !current || current == handler;
+    if (registered) {
+        handlers[IRQ_BASE + irq] = handler;
+        if (irq >= 8) enable_irq(PIC_CASCADE_IRQ);
+        enable_irq(irq);
+    }
+    irq_restore(flags);
+
+    if (!registered) {
+        log_error(LOG_INTERRUPT, "IRQ %u already has a handler\n", irq);
+    }
+    return registered;
+}
+
+void unregister_irq_handler(uint8_t irq) {
+    if (irq >= IRQ_LINES) return;
+
+    uint32_t flags = irq_save();
+    disable_irq(irq);
+    handlers[IRQ_BASE + irq] = nullptr;
+    irq_restore(flags);
+}
+
+bool register_interrupt_handler(uint8_t vector, interrupt_handler handler) {
+    if (vector >= IRQ_BASE && vector < IRQ_BASE + IRQ_LINES) {
+        return register_irq_handler(vector - IRQ_BASE, handler);
+    }
+
+    handlers[vector] = handler;
+    return true;
+}
+
+uint32_t interrupt_count(uint8_t vector) {
+    return counts[vector];
+}
+
+uint32_t irq_count(uint8_t irq) {
+    return irq < IRQ_LINES ? counts[IRQ_BASE + irq] : 0;
+}
+
+uint32_t spurious_irq_count() {
+    return spurious;
+}
+
+const irq_histogram* irq_latency_histogram(uint8_t irq) {
+    return irq < IRQ_LINES ? &latency[irq] : nullptr;
+}
+
+const irq_histogram* irq_duration_histogram(uint8_t irq) {
+    return irq < IRQ_LINES ? &duration[irq] : nullptr;
+}
+
+void set_irq_age_source(uint8_t irq, irq_age_source source) {
+    if (irq < IRQ_LINES) age_sources[irq] = source;
+}
+
+// Both run with interrupts off, from irq_save and irq_restore. Only the
+// BSP is timed: it is the CPU that serves interrupts, and the state here
+// is not per-CPU.
+void irq_off_begin(uint32_t site) {
+    if (smp_cpu_id() != 0) return;
+    off_site = site;
+    off_open = true;
+    off_start = irq_cycles();
+}
+
+void irq_off_end() {
+    if (smp_cpu_id() != 0) return;
+    uint32_t cycles = irq_cycles() - off_start;
+    // A section opened by a bare cli has nothing to measure
+    if (!off_open) return;
+    off_open = false;
+
+    histogram_add(&off_histogram, cycles);
+    if (cycles > longest_off) {
+        longest_off = cycles;
+        longest_off_site = off_site;
+    }
+}
+
+uint32_t irq_longest_off(uint32_t* site) {
+    if (site) *site = longest_off_site;
+    return longest_off;
+}
+
+const irq_histogram* irq_off_histogram() {
+    return &off_histogram;
+}
+
+static void dump_histogram(const char* name, const irq_histogram* histogram) {
+    if (!histogram->count) return;
+
+    serial_printf("    %s: max %u cycles\n", name, histogram->max);
+    for (int bucket = 0; bucket < IRQ_HIST_BUCKETS; bucket++) {
+        if (histogram->buckets[bucket]) {
+            serial_printf("      2^%-2d %u\n", bucket, histogram->buckets[bucket]);
+        }
+    }
+}
+
+void irq_stats() {
+    serial_printf("Interrupts - %u spurious\n", spurious);
+    for (int vector = 0; vector < 256; vector++) {
+        if (!counts[vector]) continue;
+
+        if (vector >= IRQ_BASE && vector < IRQ_BASE + IRQ_LINES) {
+            uint8_t irq = vector - IRQ_BASE;
+            serial_printf("  IRQ %d: %u\n", irq, counts[vector]);
+            dump_histogram("latency", &latency[irq]);
+            dump_histogram("handler", &duration[irq]);
+        } else {
+            serial_printf("  vector %d: %u\n", vector, counts[vector]);
+        }
+    }
+
+    if (off_histogram.count) {
+        serial_printf("  interrupts off: longest %u cycles at 0x%x\n",
+                      longest_off, longest_off_site);
+        dump_histogram("sections", &off_histogram);
+    }
+}
@@ -0,0 +1,113 @@
+#ifndef IRQ_HPP
+#define IRQ_HPP
+
+#include <stdint.h>
+
+#define EFLAGS_IF 0x200
+
+// Build with -DIRQ_STATS=0 to drop the latency, handler and cli timing
+#ifndef IRQ_STATS
+#define IRQ_STATS 1
+#endif
+
+// PIC lines are remapped to vectors IRQ_BASE..IRQ_BASE + IRQ_LINES - 1
+#define IRQ_BASE 32
+#define IRQ_LINES 16
+
+// What the idt.asm stubs leave on the stack: pusha, then the vector and
+// error code (0 when the CPU pushes none), then the CPU's own frame
+struct interrupt_frame {
+    uint32_t edi, esi, ebp, esp, ebx, edx, ecx, eax;
+    uint32_t vector;
+    uint32_t error_code;
+    uint32_t eip, cs, eflags;
+};
+
+typedef void (*interrupt_handler)(interrupt_frame* frame);
+
+// Handlers run with interrupts off and should only acknowledge the device
+// and raise a softirq for the rest. The dispatcher sends the EOI after the
+// handler returns. Registering unmasks the line. A line takes one handler:
+// registering it again is harmless, but a different one is refused.
+bool register_irq_handler(uint8_t irq, interrupt_handler handler);
+void unregister_irq_handler(uint8_t irq);
+// For exceptions and other non-PIC vectors; unhandled exceptions panic
+bool register_interrupt_handler(uint8_t vector, interrupt_handler handler);
+
+// Interrupts taken per vector since boot, and IRQ7/IRQ15 the PIC raised
+// without a pending request
+uint32_t interrupt_count(uint8_t vector);
+uint32_t irq_count(uint8_t irq);
+uint32_t spurious_irq_count();
+
+// TSC cycle counts in log2 buckets: bucket n holds [2^n, 2^(n+1))
+#define IRQ_HIST_BUCKETS 32
+
+struct irq_histogram {
+    uint32_t count;
+    uint32_t max;
+    uint32_t buckets[IRQ_HIST_BUCKETS];
+};
+
+// Latency runs from the line being raised to its handler starting, and
+// duration covers the handler itself. Without an age source the raise
+// time is taken as dispatcher entry, so latency is only dispatch cost.
+const irq_histogram* irq_latency_histogram(uint8_t irq);
+const irq_histogram* irq_duration_histogram(uint8_t irq);
+
+// For devices that can tell how long ago they raised their line: returns
+// that age in TSC cycles, read at dispatch before the handler runs
+typedef uint32_t (*irq_age_source)();
+void set_irq_age_source(uint8_t irq, irq_age_source source);
+
+// Longest stretch between irq_save disabling interrupts and the matching
+// irq_restore, with the address of that irq_save
+uint32_t irq_longest_off(uint32_t* site);
+const irq_histogram* irq_off_histogram();
+
+// Writes counts, histograms and the longest cli section to serial
+void irq_stats();
+
+extern "C" void interrupt_dispatch(interrupt_frame* frame);
+
+static inline __attribute__((always_inline)) uint32_t irq_cycles() {
+    uint32_t low, high;
+    asm volatile("rdtsc" : "=a"(low), "=d"(high));
+    return low;
+}
+
+void irq_off_begin(uint32_t site);
+void irq_off_end();
+
+// Disables interrupts and returns the previous EFLAGS for irq_restore, so
+// critical sections nest safely inside handlers and cli regions. Only the
+// outermost section is timed; handlers already run with interrupts off.
+static inline __attribute__((always_inline)) uint32_t irq_save() {
+    uint32_t flags;
+    asm volatile("pushfl\n\tpopl %0\n\tcli" : "=r"(flags) : : "memory");
+#if IRQ_STATS
+    if (flags & EFLAGS_IF) {
+        uint32_t site;
+        asm volatile("1: movl $1b, %0" : "=r"(site));
+        irq_off_begin(site);
+    }
+#endif
+    return flags;
+}
+
+static inline __attribute__((always_inline)) void irq_restore(uint32_t flags) {
+    if (flags & EFLAGS_IF) {
+#if IRQ_STATS
+        irq_off_end();
+#endif
+        asm volatile("sti" : : : "memory");
+    }
+}
+
+static inline bool interrupts_enabled() {
+    uint32_t flags;
+    asm volatile("pushfl\n\tpopl %0" : "=r"(flags));
+    return flags & EFLAGS_IF;
+}
+
+#endif
@@ -0,0 +1,33 @@
+#include "softirq.hpp"
+
+static softirq_handler handlers[SOFTIRQ_COUNT];
+static volatile uint32_t pending = 0;
+static volatile bool running = false;
+
+void register_softirq(softirq_id id, softirq_handler handler) {
+    handlers[id] = handler;
+}
+
+void raise_softirq(softirq_id id) {
+    __atomic_fetch_or(&pending, 1u << id, __ATOMIC_RELAXED);
+}
+
+void run_softirqs() {
+    // One pass at a time, so a handler is never run again while it is
+    // still running, e.g. by a thread that preempted the main loop
+    if (__atomic_exchange_n(&running, true, __ATOMIC_ACQUIRE)) return;
+
+    // Anything raised while these run is picked up on the next call
+    uint32_t raised = __atomic_exchange_n(&pending, 0, __ATOMIC_ACQUIRE);
+
+    for (int id = 0; raised; id++, raised >>= 1) {
+        if ((raised & 1) && handlers[id]) {
+            handlers[id]();
+        }
+    }
+    __atomic_store_n(&running, false, __ATOMIC_RELEASE);
+}
+
+bool softirq_pending() {
+    return pending != 0;
+}
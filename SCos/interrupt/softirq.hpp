@@ -0,0 +1,29 @@
+#ifndef SOFTIRQ_HPP
+#define SOFTIRQ_HPP
+
+#include <stdint.h>
+
+// Deferred halves of interrupt handlers. A handler does the minimum with
+// interrupts off and raises its softirq; the main loop then runs each
+// raised softirq once with interrupts on, however many interrupts raised
+// it in the meantime, so bursts are batched into one pass.
+//
+// Softirqs only run on the BSP, and never two passes at once, so each
+// handler can be the single consumer of whatever its IRQ queues.
+enum softirq_id {
+    SOFTIRQ_TIMER,
+    SOFTIRQ_KEYBOARD,
+    SOFTIRQ_COUNT
+};
+
+typedef void (*softirq_handler)();
+
+void register_softirq(softirq_id id, softirq_handler handler);
+// Safe from interrupt handlers
+void raise_softirq(softirq_id id);
+// Runs pending softirqs in id order; called outside interrupt context on
+// the BSP. Returns at once if another pass is already running.
+void run_softirqs();
+bool softirq_pending();
+
+#endif
@@ -0,0 +1,70 @@
+global ap_trampoline_start
+global ap_trampoline_end
+
+extern ap_boot_cr3
+extern ap_boot_stack
+extern ap_main
+
+; An AP wakes from the startup IPI in real mode at CS = page << 8, IP = 0,
+; so init_smp copies ap_trampoline_start..ap_trampoline_end to the page at
+; AP_TRAMPOLINE_ADDR (memory/pmm.hpp). The copy only knows its own segment,
+; so it addresses its data relative to ap_trampoline_start and patches in
+; its own GDT base before loading it. After the far jump the AP runs the rest from the kernel image.
+
+section .text
+
+[BITS 16]
+ap_trampoline_start:
+    cli
+    cld
+    mov ax, cs
+    mov ds, ax
+
+    xor eax, eax
+    mov ax, cs
+    shl eax, 4
+    add eax, ap_gdt - ap_trampoline_start
+    mov [ap_gdt_ptr - ap_trampoline_start + 2], eax
+    lgdt [ap_gdt_ptr - ap_trampoline_start]
+
+    mov eax, cr0
+    or eax, 1
+    mov cr0, eax
+    jmp dword 0x08:ap_protected_mode
+
+align 8
+ap_gdt:
+    dq 0
+    dq 0x00CF9A000000FFFF       ; code: base 0, 4 GB, ring 0
+    dq 0x00CF92000000FFFF       ; data: base 0, 4 GB, ring 0
+ap_gdt_ptr:
+    dw ap_gdt_ptr - ap_gdt - 1
+    dd 0
+
+ap_trampoline_end:
+
+
+[BITS 32]
+; Same paging setup as the BSP: the shared page directory with 4 MB pages
+ap_protected_mode:
+    mov ax, 0x10
+    mov ds, ax
+    mov es, ax
+    mov fs, ax
+    mov gs, ax
+    mov ss, ax
+
+    mov eax, cr4
+    or eax, 0x10                ; CR4.PSE
+    mov cr4, eax
+    mov eax, [ap_boot_cr3]
+    mov cr3, eax
+    mov eax, cr0
+    or eax, 0x80000000          ; CR0.PG
+    mov cr0, eax
+
+    mov esp, [ap_boot_stack]
+    call ap_main
+.halt:
+    hlt
+    jmp .halt
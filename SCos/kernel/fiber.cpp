@@ -0,0 +1,161 @@
+#include "fiber.hpp"
+#include "../drivers/timer.hpp"
+#include "../memory/heap.hpp"
+#include "../debug/log.hpp"
+#include "../debug/serial.hpp"
+#include "../include/kernel.h"
+
+#define FIBER_STACK_CANARY 0xF1BE5AFE
+
+enum fiber_state {
+    FIBER_UNUSED,
+    FIBER_READY,
+    FIBER_SLEEPING,
+    FIBER_WAITING,
+    FIBER_DONE
+};
+
+// kernel/switch.asm; the same switch threads use
+extern "C" void switch_context(uint32_t* save_esp, uint32_t load_esp);
+
+static fiber fibers[MAX_FIBERS];
+static fiber* running = nullptr;
+// run_fibers' own stack pointer while a fiber runs
+static uint32_t scheduler_esp = 0;
+static uint32_t fiber_switches = 0;
+
+// Hands the CPU back to run_fibers; returns when the fiber is resumed
+static void fiber_switch_out() {
+    fiber* self = running;
+    switch_context(&self->esp, scheduler_esp);
+}
+
+static void fiber_start() {
+    running->entry(running->arg);
+    running->state = FIBER_DONE;
+    fiber_switch_out();
+}
+
+fiber* fiber_create(const char* name, fiber_entry entry, void* arg) {
+    fiber* f = nullptr;
+    for (int i = 0; i < MAX_FIBERS; i++) {
+        if (fibers[i].state == FIBER_UNUSED) {
+            f = &fibers[i];
+            break;
+        }
+    }
+    if (!f) {
+        log_error(LOG_KERNEL, "No free fiber slot for %s\n", name);
+        return nullptr;
+    }
+
+    f->stack = (uint8_t*)kmalloc(FIBER_STACK_SIZE);
+    if (!f->stack) {
+        log_error(LOG_KERNEL, "No memory for the stack of fiber %s\n", name);
+        return nullptr;
+    }
+    *(uint32_t*)f->stack = FIBER_STACK_CANARY;
+
+    // The frame switch_context pops: edi, esi, ebx, ebp, return address
+    uint32_t* sp = (uint32_t*)(f->stack + FIBER_STACK_SIZE);
+    *--sp = (uint32_t)fiber_start;
+    for (int i = 0; i < 4; i++) {
+        *--sp = 0;
+    }
+
+    f->esp = (uint32_t)sp;
+    f->entry = entry;
+    f->arg = arg;
+    f->name = name;
+    f->waiting_on = nullptr;
+    f->switches = 0;
+    f->state = FIBER_READY;
+    return f;
+}
+
+bool in_fiber() {
+    return running != nullptr;
+}
+
+void fiber_yield() {
+    if (!running) return;
+    fiber_switch_out();
+}
+
+void fiber_sleep_until(uint64_t deadline) {
+    if (!running || ktime_expired(deadline)) return;
+
+    running->state = FIBER_SLEEPING;
+    running->wake_at = deadline;
+    fiber_switch_out();
+}
+
+void fiber_sleep_ms(uint32_t ms) {
+    fiber_sleep_until(ktime_deadline_ms(ms));
+}
+
+void fiber_await_io(fiber_event* event) {
+    if (!running || event->signalled) return;
+
+    running->state = FIBER_WAITING;
+    running->waiting_on = event;
+    fiber_switch_out();
+    running->waiting_on = nullptr;
+}
+
+void fiber_event_init(fiber_event* event) {
+    event->signalled = false;
+}
+
+// The release store orders whatever the signaller wrote before it, which
+// matters when the signal comes from a job on another CPU
+void fiber_signal(fiber_event* event) {
+    __atomic_store_n(&event->signalled, true, __ATOMIC_RELEASE);
+}
+
+bool run_fibers() {
+    bool again = false;
+
+    for (int i = 0; i < MAX_FIBERS; i++) {
+        fiber* f = &fibers[i];
+        if (f->state == FIBER_SLEEPING && ktime_expired(f->wake_at)) {
+            f->state = FIBER_READY;
+        } else if (f->state == FIBER_WAITING && f->waiting_on->signalled) {
+            f->state = FIBER_READY;
+        }
+        if (f->state != FIBER_READY) continue;
+
+        running = f;
+        f->switches++;
+        fiber_switches++;
+        switch_context(&scheduler_esp, f->esp);
+        running = nullptr;
+
+        if (*(uint32_t*)f->stack != FIBER_STACK_CANARY) {
+            log_error(LOG_KERNEL, "Fiber %s overflowed its stack\n", f->name);
+            kernel_panic("Fiber stack overflow");
+        }
+
+        if (f->state == FIBER_DONE) {
+            kfree(f->stack);
+            f->stack = nullptr;
+            f->state = FIBER_UNUSED;
+        } else if (f->state == FIBER_READY) {
+            again = true;
+        }
+    }
+    return again;
+}
+
+void fiber_stats() {
+    static const char* const state_names[] = {
+        "unused", "ready", "sleeping", "waiting", "done"
+    };
+
+    serial_printf("Fibers - %u switches\n", fiber_switches);
+    for (int i = 0; i < MAX_FIBERS; i++) {
+        fiber* f = &fibers[i];
+        if (f->state == FIBER_UNUSED) continue;
+        serial_printf("  %s: %s, resumed %u times\n", f->name, state_names[f->state], f->switches);
+    }
+}
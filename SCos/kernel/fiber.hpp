@@ -0,0 +1,59 @@
+#ifndef FIBER_HPP
+#define FIBER_HPP
+
+#include <stdint.h>
+
+// Cooperative fibers for long sequential app work. Each fiber has its own
+// stack but they all run on the desktop thread, one at a time, from
+// run_fibers() in the main loop, so they share the desktop's data without
+// locks. A fiber only gives up the CPU at fiber_yield, fiber_sleep_* or
+// fiber_await_io; switching is a swap of four registers and a stack.
+// Fibers must not call ksleep_ms, which would stall the whole desktop.
+
+#define MAX_FIBERS 8
+#define FIBER_STACK_SIZE (8 * 1024)
+
+typedef void (*fiber_entry)(void* arg);
+
+// Completion flag a fiber can wait on. It may be signalled from anywhere,
+// including interrupt handlers and other CPUs; the waiter resumes on the
+// next pass.
+struct fiber_event {
+    volatile bool signalled;
+};
+
+struct fiber {
+    uint32_t esp;
+    uint8_t* stack;
+    fiber_entry entry;
+    void* arg;
+    const char* name;
+    uint8_t state;
+    uint64_t wake_at;
+    fiber_event* waiting_on;
+    uint32_t switches;
+};
+
+// Starts on the next run_fibers pass; returns nullptr when the fiber
+// table or the heap is exhausted
+fiber* fiber_create(const char* name, fiber_entry entry, void* arg);
+// Whether the caller is running on a fiber stack
+bool in_fiber();
+
+// Only valid inside a fiber. Each returns to run_fibers and resumes once
+// its condition holds; yield resumes on the next pass.
+void fiber_yield();
+void fiber_sleep_until(uint64_t deadline);
+void fiber_sleep_ms(uint32_t ms);
+void fiber_await_io(fiber_event* event);
+
+void fiber_event_init(fiber_event* event);
+void fiber_signal(fiber_event* event);
+
+// Resumes every runnable fiber once and frees finished ones. Returns
+// whether any fiber could run again straight away, in which case the
+// caller should not wait for an interrupt.
+bool run_fibers();
+void fiber_stats();
+
+#endif
@@ -0,0 +1,53 @@
+#include "gdt.hpp"
+#include "percpu.hpp"
+
+// Null, code and data, then one per-CPU data segment per CPU
+#define GDT_PERCPU_FIRST 3
+#define GDT_ENTRIES (GDT_PERCPU_FIRST + MAX_CPUS)
+
+static gdt_entry gdt[GDT_ENTRIES];
+static gdt_ptr gdtp;
+
+static void set_gdt_entry(int n, uint32_t base, uint32_t limit, uint8_t access, uint8_t flags) {
+    gdt[n].limit_low = limit & 0xFFFF;
+    gdt[n].base_low = base & 0xFFFF;
+    gdt[n].base_mid = (base >> 16) & 0xFF;
+    gdt[n].access = access;
+    gdt[n].granularity = (flags & 0xF0) | ((limit >> 16) & 0x0F);
+    gdt[n].base_high = (base >> 24) & 0xFF;
+}
+
+bool init_gdt() {
+    set_gdt_entry(0, 0, 0, 0, 0);
+    // Flat 4 GB ring-0 segments at the selectors the boot sector used
+    set_gdt_entry(1, 0, 0xFFFFF, 0x9A, 0xC0);
+    set_gdt_entry(2, 0, 0xFFFFF, 0x92, 0xC0);
+
+    // Byte-granular, covering just one cpu_info each
+    for (uint32_t i = 0; i < MAX_CPUS; i++) {
+        cpus[i].self = &cpus[i];
+        cpus[i].index = i;
+        set_gdt_entry(GDT_PERCPU_FIRST + i, (uint32_t)&cpus[i], sizeof(cpu_info) - 1, 0x92, 0x40);
+    }
+
+    gdtp.limit = sizeof(gdt) - 1;
+    gdtp.base = (uint32_t)&gdt;
+    gdt_load_cpu(0);
+    return true;
+}
+
+void gdt_load_cpu(uint32_t index) {
+    uint32_t percpu = (GDT_PERCPU_FIRST + index) * sizeof(gdt_entry);
+    asm volatile(
+        "lgdt %0\n"
+        "ljmp %1, $1f\n"             // reload CS from the new table
+        "1:\n"
+        "mov %2, %%eax\n"
+        "mov %%eax, %%ds\n"
+        "mov %%eax, %%es\n"
+        "mov %%eax, %%fs\n"
+        "mov %%eax, %%ss\n"
+        "mov %3, %%gs\n"
+        : : "m"(gdtp), "i"(GDT_CODE_SELECTOR), "i"(GDT_DATA_SELECTOR), "r"(percpu)
+        : "eax", "memory");
+}
@@ -0,0 +1,31 @@
+#ifndef GDT_HPP
+#define GDT_HPP
+
+#include <stdint.h>
+
+#define GDT_CODE_SELECTOR 0x08
+#define GDT_DATA_SELECTOR 0x10
+
+struct gdt_entry {
+    uint16_t limit_low;
+    uint16_t base_low;
+    uint8_t base_mid;
+    uint8_t access;
+    uint8_t granularity;
+    uint8_t base_high;
+} __attribute__((packed));
+
+struct gdt_ptr {
+    uint16_t limit;
+    uint32_t base;
+} __attribute__((packed));
+
+// Replaces the boot sector's GDT, whose memory the kernel image overlaps,
+// with one that also has a per-CPU segment for each CPU. Runs first thing
+// in _start, since this_cpu() and smp_cpu_id() depend on it.
+bool init_gdt();
+// Loads the kernel GDT on the calling CPU and points its %gs at
+// cpus[index]; APs call it on their way up
+void gdt_load_cpu(uint32_t index);
+
+#endif
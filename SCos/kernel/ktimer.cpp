@@ -0,0 +1,156 @@
+#include "ktimer.hpp"
+#include "../drivers/timer.hpp"
+#include "../interrupt/irq.hpp"
+#include "../interrupt/softirq.hpp"
+
+// Four levels of 64 slots. A timer sits at the level whose span covers its
+// remaining delay; whenever a level completes a revolution, the matching
+// slot of the next level is cascaded down, so each timer is re-filed at
+// most once per level before it reaches level 0 and expires.
+#define WHEEL_LEVELS 4
+#define WHEEL_BITS 6
+#define WHEEL_SLOTS (1 << WHEEL_BITS)
+#define WHEEL_MASK (WHEEL_SLOTS - 1)
+// Ticks the wheel can see ahead; later timers wait in the top level and
+// are re-filed when it comes round
+#define WHEEL_RANGE (1u << (WHEEL_LEVELS * WHEEL_BITS))
+
+static ktimer* wheel[WHEEL_LEVELS][WHEEL_SLOTS];
+// Expired timers waiting for run_timers()
+static ktimer* ready_list = nullptr;
+static volatile uint32_t wheel_now = 0;
+
+static void list_add(ktimer** head, ktimer* timer) {
+    timer->next = *head;
+    if (*head) (*head)->pprev = &timer->next;
+    *head = timer;
+    timer->pprev = head;
+}
+
+static void list_del(ktimer* timer) {
+    *timer->pprev = timer->next;
+    if (timer->next) timer->next->pprev = timer->pprev;
+    timer->next = nullptr;
+    timer->pprev = nullptr;
+}
+
+static void wheel_insert(ktimer* timer) {
+    uint32_t delta = timer->expires - wheel_now;
+    uint32_t target = timer->expires;
+
+    // A timer cascaded on its expiry tick lands in the level-0 slot that
+    // ktimer_tick is about to run
+    if ((int32_t)delta < 0) {
+        target = wheel_now;
+        delta = 0;
+    } else if (delta >= WHEEL_RANGE) {
+        target = wheel_now + WHEEL_RANGE - 1;
+        delta = WHEEL_RANGE - 1;
+    }
+
+    int level = 0;
+    while (delta >= (1u << ((level + 1) * WHEEL_BITS))) {
+        level++;
+    }
+    list_add(&wheel[level][(target >> (level * WHEEL_BITS)) & WHEEL_MASK], timer);
+}
+
+static void cascade(int level, int slot) {
+    ktimer* timer = wheel[level][slot];
+    wheel[level][slot] = nullptr;
+
+    while (timer) {
+        ktimer* next = timer->next;
+        wheel_insert(timer);
+        timer = next;
+    }
+}
+
+// Rounds up so a timer never fires early
+static uint32_t ms_to_ticks(uint32_t ms) {
+    uint32_t hz = timer_hz();
+    uint32_t ticks = ms / 1000 * hz + (ms % 1000 * hz + 999) / 1000;
+    return ticks ? ticks : 1;
+}
+
+bool init_ktimers() {
+    for (int level = 0; level < WHEEL_LEVELS; level++) {
+        for (int slot = 0; slot < WHEEL_SLOTS; slot++) {
+            wheel[level][slot] = nullptr;
+        }
+    }
+    ready_list = nullptr;
+    wheel_now = 0;
+    register_softirq(SOFTIRQ_TIMER, run_timers);
+    return true;
+}
+
+void ktimer_init(ktimer* timer, ktimer_callback callback, void* data) {
+    // Clearing the links of a filed timer would leave its slot pointing at
+    // it, and the next ktimer_start would file it a second time
+    ktimer_cancel(timer);
+
+    timer->next = nullptr;
+    timer->pprev = nullptr;
+    timer->expires = 0;
+    timer->callback = callback;
+    timer->data = data;
+}
+
+void ktimer_start(ktimer* timer, uint32_t ms) {
+    uint32_t flags = irq_save();
+
+    if (timer->pprev) list_del(timer);
+    timer->expires = wheel_now + ms_to_ticks(ms);
+    wheel_insert(timer);
+
+    irq_restore(flags);
+}
+
+bool ktimer_cancel(ktimer* timer) {
+    uint32_t flags = irq_save();
+
+    bool pending = timer->pprev != nullptr;
+    if (pending) list_del(timer);
+
+    irq_restore(flags);
+    return pending;
+}
+
+bool ktimer_pending(const ktimer* timer) {
+    return timer->pprev != nullptr;
+}
+
+void ktimer_tick() {
+    uint32_t now = wheel_now + 1;
+    wheel_now = now;
+
+    for (int level = 1; level < WHEEL_LEVELS; level++) {
+        if (now & ((1u << (level * WHEEL_BITS)) - 1)) break;
+        cascade(level, (now >> (level * WHEEL_BITS)) & WHEEL_MASK);
+    }
+
+    // Everything left in this level-0 slot is due now
+    ktimer** slot = &wheel[0][now & WHEEL_MASK];
+    while (*slot) {
+        ktimer* timer = *slot;
+        list_del(timer);
+        list_add(&ready_list, timer);
+    }
+
+    if (ready_list) {
+        raise_softirq(SOFTIRQ_TIMER);
+    }
+}
+
+void run_timers() {
+    for (;;) {
+        uint32_t flags = irq_save();
+        ktimer* timer = ready_list;
+        if (timer) list_del(timer);
+        irq_restore(flags);
+
+        if (!timer) break;
+        timer->callback(timer->data);
+    }
+}
@@ -0,0 +1,39 @@
+#ifndef KTIMER_HPP
+#define KTIMER_HPP
+
+#include <stdint.h>
+
+// One-shot kernel timers on a hierarchical timer wheel. Arming and
+// cancelling are O(1), and each tick touches one slot plus an occasional
+// cascade, so the tick cost does not grow with the number of pending
+// timers. The IRQ0 tick only moves expired timers to a ready list; the
+// callbacks run later from the timer softirq with interrupts enabled.
+
+typedef void (*ktimer_callback)(void* data);
+
+// Callers own the storage; a timer must stay alive while it is pending
+// and start out zeroed (static or kcalloc), so that ktimer_init can tell a
+// pending timer from a fresh one
+struct ktimer {
+    ktimer* next;
+    ktimer** pprev;
+    uint32_t expires;
+    ktimer_callback callback;
+    void* data;
+};
+
+bool init_ktimers();
+// Sets the callback; a timer still pending is cancelled first
+void ktimer_init(ktimer* timer, ktimer_callback callback, void* data);
+// Arms, or re-arms, the timer to fire after at least `ms` milliseconds
+void ktimer_start(ktimer* timer, uint32_t ms);
+// Returns whether the timer was pending; it will not fire afterwards
+bool ktimer_cancel(ktimer* timer);
+bool ktimer_pending(const ktimer* timer);
+
+// Advances the wheel by one tick; called from the IRQ0 handler
+void ktimer_tick();
+// Runs the callbacks of expired timers; the timer softirq handler
+void run_timers();
+
+#endif
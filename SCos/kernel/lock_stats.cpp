@@ -0,0 +1,27 @@
+#include "lock_stats.hpp"
+#include "../debug/serial.hpp"
+#include "../include/div64.h"
+
+static lock_stats* volatile listed_locks = nullptr;
+
+// Lock-free push, since it runs inside whichever lock is first taken.
+// Only the winner of the exchange on `listed` pushes.
+void lock_stats_list(lock_stats* stats) {
+    if (__atomic_exchange_n(&stats->listed, 1, __ATOMIC_ACQ_REL)) return;
+
+    lock_stats* head = listed_locks;
+    do {
+        stats->next = head;
+    } while (!__atomic_compare_exchange_n(&listed_locks, &head, stats, false,
+                                          __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+}
+
+void lock_stats_dump() {
+    serial_printf("Locks - acquires, shared, contended, average wait, average and max hold (cycles)\n");
+    for (lock_stats* stats = listed_locks; stats; stats = stats->next) {
+        uint32_t wait = stats->contended ? (uint32_t)div64_32(stats->wait_cycles, stats->contended) : 0;
+        uint32_t hold = stats->acquires ? (uint32_t)div64_32(stats->hold_cycles, stats->acquires) : 0;
+        serial_printf("  %s: %u, %u, %u, %u, %u, %u\n", stats->name, stats->acquires,
+                      stats->shared, stats->contended, wait, hold, stats->hold_max);
+    }
+}
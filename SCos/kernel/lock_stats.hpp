@@ -0,0 +1,61 @@
+#ifndef LOCK_STATS_HPP
+#define LOCK_STATS_HPP
+
+#include <stdint.h>
+#include "../interrupt/irq.hpp"
+
+// Build with -DLOCK_STATS=0 to drop the accounting from every lock
+#ifndef LOCK_STATS
+#define LOCK_STATS 1
+#endif
+
+// Optional per-lock counters. A lock keeps them only when it is given a
+// lock_stats at initialisation; the first acquisition adds them to the
+// list lock_stats_dump() prints. Cycles are TSC cycles. Exclusive holders
+// update the counters while they still own the lock, so they need no
+// atomics; shared (reader) acquisitions are only counted, atomically.
+struct lock_stats {
+    const char* name;
+    lock_stats* next;
+    volatile uint32_t listed;
+    uint32_t acquires;          // exclusive
+    uint32_t shared;
+    uint32_t contended;         // acquisitions of either kind that waited
+    uint64_t wait_cycles;
+    uint64_t hold_cycles;
+    uint32_t hold_max;
+    uint32_t held_since;
+};
+
+#define LOCK_STATS_INIT(name) {(name), nullptr, 0, 0, 0, 0, 0, 0, 0, 0}
+
+void lock_stats_list(lock_stats* stats);
+// Writes every listed lock's counters to serial
+void lock_stats_dump();
+
+static inline void lock_stats_acquired(lock_stats* stats, bool contended, uint32_t start) {
+    uint32_t now = irq_cycles();
+    if (!stats->listed) lock_stats_list(stats);
+
+    stats->acquires++;
+    if (contended) {
+        stats->contended++;
+        stats->wait_cycles += now - start;
+    }
+    stats->held_since = now;
+}
+
+static inline void lock_stats_released(lock_stats* stats) {
+    uint32_t held = irq_cycles() - stats->held_since;
+    stats->hold_cycles += held;
+    if (held > stats->hold_max) stats->hold_max = held;
+}
+
+static inline void lock_stats_shared(lock_stats* stats, bool contended) {
+    if (!stats->listed) lock_stats_list(stats);
+
+    __atomic_add_fetch(&stats->shared, 1, __ATOMIC_RELAXED);
+    if (contended) __atomic_add_fetch(&stats->contended, 1, __ATOMIC_RELAXED);
+}
+
+#endif
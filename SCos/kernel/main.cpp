@@ -1,17 +1,32 @@
 #include "../ui/desktop.hpp"
 #include "../fs/ramfs.hpp"
 #include "../drivers/keyboard.hpp"
+#include "../drivers/timer.hpp"
+#include "ktimer.hpp"
+#include "thread.hpp"
+#include "fiber.hpp"
+#include "gdt.hpp"
+#include "smp.hpp"
 #include "../drivers/network.hpp"
 #include "../drivers/bluetooth.hpp"
 #include "../memory/heap.hpp"
+#include "../memory/pmm.hpp"
+#include "../memory/paging.hpp"
+#include "../memory/buddy.hpp"
 #include "../interrupt/idt.hpp"
+#include "../interrupt/softirq.hpp"
 #include <stdint.h>
 #include "../include/stddef.h"
 #include "../include/stdarg.h"
 #include "../debug/serial.hpp"
+#include "../debug/trace.hpp"
+#include "../debug/log.hpp"
 #include "../include/kernel.h"
 #include "../include/memory.h"
 
+// Spinner and heartbeat log interval of the main loop
+#define HEARTBEAT_MS 500
+
 extern "C" {
     extern void* __CTOR_LIST__;
     extern void* __CTOR_END__;
@@ -32,6 +47,8 @@ extern "C" {
 
     void kernel_panic(const char* message) {
         asm volatile("cli");
+        // Queued output would never drain with interrupts off
+        serial_flush();
         serial_printf("KERNEL PANIC: %s\n", message);
         serial_printf("System halted.\n");
         while (1) {
@@ -40,69 +57,114 @@ extern "C" {
     }
 
     bool init_subsystems() {
-        serial_printf("Initializing kernel subsystems...\n");
+        log_debug(LOG_KERNEL, "Initializing kernel subsystems...\n");
 
-        serial_printf("Serial: OK\n");
+        log_info(LOG_KERNEL, "Serial: OK\n");
 
-        serial_printf("Initializing IDT...\n");
+        log_debug(LOG_KERNEL, "Initializing IDT...\n");
         if (!init_idt()) {
-            serial_printf("IDT: FAILED\n");
+            log_error(LOG_KERNEL, "IDT: FAILED\n");
+            return false;
+        }
+        log_info(LOG_KERNEL, "IDT: OK\n");
+
+        log_debug(LOG_KERNEL, "Initializing Timer...\n");
+        if (!init_timer(TIMER_HZ)) {
+            log_error(LOG_KERNEL, "Timer: FAILED\n");
+            return false;
+        }
+        log_info(LOG_KERNEL, "Timer: %u Hz, TSC %u kHz\n", timer_hz(), tsc_khz());
+        init_ktimers();
+
+        log_debug(LOG_KERNEL, "Initializing Physical Memory...\n");
+        if (!init_pmm()) {
+            log_error(LOG_KERNEL, "Physical Memory: FAILED\n");
             return false;
         }
-        serial_printf("IDT: OK\n");
+        log_info(LOG_KERNEL, "Physical Memory: OK\n");
 
-        serial_printf("Initializing Heap...\n");
+        log_debug(LOG_KERNEL, "Initializing Paging...\n");
+        if (!init_paging()) {
+            log_error(LOG_KERNEL, "Paging: FAILED\n");
+            return false;
+        }
+        log_info(LOG_KERNEL, "Paging: OK\n");
+
+        log_debug(LOG_KERNEL, "Initializing Heap...\n");
         if (!init_heap()) {
-            serial_printf("Heap: FAILED\n");
+            log_error(LOG_KERNEL, "Heap: FAILED\n");
+            return false;
+        }
+        log_info(LOG_KERNEL, "Heap: OK\n");
+
+        log_debug(LOG_KERNEL, "Initializing Page Allocator...\n");
+        if (!init_buddy()) {
+            log_error(LOG_KERNEL, "Page Allocator: FAILED\n");
             return false;
         }
-        serial_printf("Heap: OK\n");
+        log_info(LOG_KERNEL, "Page Allocator: OK\n");
 
-        serial_printf("Initializing Keyboard...\n");
+        log_debug(LOG_KERNEL, "Initializing Threads...\n");
+        if (!init_threads()) {
+            log_error(LOG_KERNEL, "Threads: FAILED\n");
+            return false;
+        }
+        log_info(LOG_KERNEL, "Threads: OK\n");
+
+        log_debug(LOG_KERNEL, "Initializing SMP...\n");
+        if (!init_smp()) {
+            log_error(LOG_KERNEL, "SMP: FAILED\n");
+            return false;
+        }
+        log_info(LOG_KERNEL, "SMP: %u CPUs\n", smp_cpu_count());
+
+        log_debug(LOG_KERNEL, "Initializing Keyboard...\n");
         if (!init_keyboard()) {
-            serial_printf("Keyboard: FAILED\n");
+            log_error(LOG_KERNEL, "Keyboard: FAILED\n");
             return false;
         }
-        serial_printf("Keyboard: OK\n");
+        log_info(LOG_KERNEL, "Keyboard: OK\n");
 
-        serial_printf("Initializing Filesystem...\n");
+        log_debug(LOG_KERNEL, "Initializing Filesystem...\n");
         if (!initFS()) {
-            serial_printf("Filesystem: FAILED\n");
+            log_error(LOG_KERNEL, "Filesystem: FAILED\n");
             return false;
         }
-        serial_printf("Filesystem: OK\n");
+        log_info(LOG_KERNEL, "Filesystem: OK\n");
 
-        serial_printf("Initializing Network Driver...\n");
+        log_debug(LOG_KERNEL, "Initializing Network Driver...\n");
         NetworkDriver::init();
-        serial_printf("Network Driver: OK\n");
+        log_info(LOG_KERNEL, "Network Driver: OK\n");
 
-        serial_printf("Initializing Bluetooth Driver...\n");
+        log_debug(LOG_KERNEL, "Initializing Bluetooth Driver...\n");
         BluetoothDriver::init();
-        serial_printf("Bluetooth Driver: OK\n");
+        log_info(LOG_KERNEL, "Bluetooth Driver: OK\n");
 
-        serial_printf("All subsystems initialized successfully\n");
+        log_info(LOG_KERNEL, "All subsystems initialized successfully\n");
         return true;
     }
 }
 
 void show_memory_info() {
-    serial_printf("=== MEMORY LAYOUT ===\n");
-    serial_printf("Kernel loaded at: 0x1000\n");
-    serial_printf("Kernel end: 0x%x\n", _kernel_end);
-    serial_printf("Kernel size: %d KB\n", (_kernel_end - 0x1000) / 1024);
-    serial_printf("Available memory starts at: 0x%x\n", _kernel_end);
+    log_debug(LOG_KERNEL, "=== MEMORY LAYOUT ===\n");
+    log_debug(LOG_KERNEL, "Kernel loaded at: 0x1000\n");
+    log_debug(LOG_KERNEL, "Kernel end: 0x%x\n", _kernel_end);
+    log_debug(LOG_KERNEL, "Kernel size: %d KB\n", (_kernel_end - 0x1000) / 1024);
+    log_debug(LOG_KERNEL, "Available memory starts at: 0x%x\n", _kernel_end);
     
-    serial_printf("Expected QEMU layout:\n");
-    serial_printf("  - Low memory: 0x0 - 0x9FFFF (640KB)\n");
-    serial_printf("  - High memory: 0x100000+ (1MB+)\n");
-    serial_printf("  - Our kernel: 0x1000 - 0x%x\n", _kernel_end);
-    serial_printf("===================\n");
+    log_debug(LOG_KERNEL, "Expected QEMU layout:\n");
+    log_debug(LOG_KERNEL, "  - Low memory: 0x0 - 0x9FFFF (640KB)\n");
+    log_debug(LOG_KERNEL, "  - High memory: 0x100000+ (1MB+)\n");
+    log_debug(LOG_KERNEL, "  - Our kernel: 0x1000 - 0x%x\n", _kernel_end);
+    log_debug(LOG_KERNEL, "===================\n");
 }
 
 extern "C" void _start() __attribute__((section(".text._start")));
 
 extern "C" void _start() {
     asm volatile("cli");
+    // Before anything that asks which CPU it is on
+    init_gdt();
     
     volatile uint16_t* video_memory = (volatile uint16_t*)0xB8000;
     for (int i = 0; i < 80 * 25; i++) {
@@ -121,8 +183,6 @@ extern "C" void _start() {
     
     write_text(0, 0, "SCos Boot", 0x0F);
     
-    for (volatile int i = 0; i < 100000; i++);
-    
     write_text(0, 1, "Serial init...", 0x0E);
     
     bool serial_ok = init_serial();
@@ -133,12 +193,16 @@ extern "C" void _start() {
     }
     
     if (serial_ok) {
-        serial_printf("SCos Kernel Starting...\n");
-        serial_printf("Version: 0.1.0\n");
+        log_info(LOG_KERNEL, "SCos Kernel Starting...\n");
+        log_info(LOG_KERNEL, "Version: 0.1.0\n");
         show_memory_info();
-        serial_printf("Global constructors called\n");
+        log_info(LOG_KERNEL, "Global constructors called\n");
     }
 
+    // Before the constructors so their allocations are traced too
+    init_log();
+    init_trace();
+
     write_text(0, 3, "Constructors...", 0x0E);
     call_constructors();
     write_text(0, 4, "Constructors OK", 0x0B);
@@ -146,7 +210,7 @@ extern "C" void _start() {
     write_text(0, 5, "Init subsystems...", 0x0E);
     
     if (serial_ok) {
-        serial_printf("Starting subsystem initialization...\n");
+        log_info(LOG_KERNEL, "Starting subsystem initialization...\n");
     }
     
     bool init_success = init_subsystems();
@@ -154,45 +218,54 @@ extern "C" void _start() {
     if (!init_success) {
         write_text(0, 6, "Subsystem FAIL", 0x0C);
         if (serial_ok) {
-            serial_printf("Subsystem initialization failed - continuing anyway\n");
+            log_error(LOG_KERNEL, "Subsystem initialization failed - continuing anyway\n");
         }
     } else {
         write_text(0, 6, "Subsystems OK", 0x0A);
         if (serial_ok) {
-            serial_printf("Subsystem initialization completed successfully\n");
+            log_info(LOG_KERNEL, "Subsystem initialization completed successfully\n");
         }
     }
 
-    serial_printf("Creating desktop object...\n");
+    log_debug(LOG_KERNEL, "Creating desktop object...\n");
     Desktop desktop;
     
-    serial_printf("Initializing desktop...\n");
+    log_debug(LOG_KERNEL, "Initializing desktop...\n");
     if (!desktop.init()) {
         write_text(0, 7, "CRITICAL: Desktop initialization failed!", 0x0C);
-        serial_printf("Desktop initialization failed!\n");
+        log_error(LOG_KERNEL, "Desktop initialization failed!\n");
         kernel_panic("Desktop environment initialization failed");
     }
     
     write_text(0, 7, "Desktop environment ready - SCos loaded!", 0x0E);
-    serial_printf("Desktop initialized successfully\n");
-    serial_printf("Desktop environment loaded successfully\n");
-    serial_printf("Enabling interrupts and entering main loop...\n");
+    log_info(LOG_KERNEL, "Desktop initialized successfully\n");
+    log_info(LOG_KERNEL, "Desktop environment loaded successfully\n");
+    log_info(LOG_KERNEL, "Enabling interrupts and entering main loop...\n");
 
     asm volatile("sti");
+    serial_enable_interrupts();
 
     write_text(0, 8, "SCos boot complete - System ready!", 0x0F);
-    serial_printf("Starting main kernel loop...\n");
-    
-    uint32_t tick_count = 0;
-    uint32_t heartbeat_interval = 100000;
+    log_info(LOG_KERNEL, "Starting main kernel loop...\n");
     
+    // The loop sleeps between interrupts, so the heartbeat is paced by the
+    // clock rather than by counting passes
+    uint32_t heartbeat_count = 0;
+    uint64_t next_heartbeat = ktime_deadline_ms(HEARTBEAT_MS);
+
     while (1) {
+        run_softirqs();
         desktop.handle_events();
+        bool fibers_ready = run_fibers();
         desktop.update();
 
-        tick_count++;
-        if (tick_count % heartbeat_interval == 0) {
-            serial_printf("Kernel heartbeat: %d\n", tick_count / heartbeat_interval);
+        if (ktime_expired(next_heartbeat)) {
+            next_heartbeat = ktime_deadline_ms(HEARTBEAT_MS);
+            heartbeat_count++;
+            log_debug(LOG_KERNEL, "Kernel heartbeat: %u\n", heartbeat_count);
+            if (serial_dropped()) {
+                log_warn(LOG_KERNEL, "Serial bytes dropped: %u\n", serial_dropped());
+            }
             
             static char heartbeat_chars[] = {'|', '-', '\\', '/'};
             static int heartbeat_index = 0;
@@ -201,9 +274,14 @@ extern "C" void _start() {
             heartbeat_index = (heartbeat_index + 1) % 4;
         }
 
-        asm volatile("pause");
-        
-        asm volatile("hlt");
+        // This is the high-priority thread; background threads get the
+        // CPU until the next interrupt brings input or a tick. Fibers that
+        // only yielded want another pass straight away.
+        if (fibers_ready) {
+            thread_yield();
+        } else {
+            thread_wait_interrupt();
+        }
     }
 }
 
@@ -212,11 +290,11 @@ extern "C" void __cxa_pure_virtual() {
 }
 
 void* operator new(size_t size) {
-    return kmalloc(size);
+    return kmalloc_caller(size, __builtin_return_address(0));
 }
 
 void* operator new[](size_t size) {
-    return kmalloc(size);
+    return kmalloc_caller(size, __builtin_return_address(0));
 }
 
 void operator delete(void* ptr) {
@@ -0,0 +1,35 @@
+#ifndef PERCPU_HPP
+#define PERCPU_HPP
+
+#include <stdint.h>
+
+// Per-CPU data. Every CPU's %gs selects a small GDT segment based at its
+// own cpu_info (see gdt.cpp), so finding the current CPU is one load, with
+// no LAPIC read and no interrupts-off section around it.
+
+#define MAX_CPUS 8
+
+struct cpu_info {
+    cpu_info* self;         // %gs:0
+    uint32_t index;         // %gs:4; the BSP is 0
+    uint32_t apic_id;
+    volatile bool online;
+    uint32_t jobs_run;
+    uint32_t jobs_stolen;
+};
+
+extern cpu_info cpus[MAX_CPUS];
+
+static inline cpu_info* this_cpu() {
+    cpu_info* cpu;
+    asm volatile("movl %%gs:0, %0" : "=r"(cpu));
+    return cpu;
+}
+
+static inline uint32_t smp_cpu_id() {
+    uint32_t index;
+    asm volatile("movl %%gs:4, %0" : "=r"(index));
+    return index;
+}
+
+#endif
@@ -0,0 +1,230 @@
+#ifndef RING_HPP
+#define RING_HPP
+
+#include <stdint.h>
+
+// Bounded lock-free rings for handing data from an interrupt handler or
+// another CPU to a single consumer. N must be a power of two so a slot is
+// found by masking a free-running index, and T must be safe to copy with
+// plain assignment.
+//
+// The producer and consumer indices sit on their own cache lines, so the
+// two sides only share a line when one actually has to see the other's
+// progress. Each side also caches the last index it read from the other
+// and only reloads it when the cached value says the ring is full or
+// empty.
+//
+// A zero-filled ring is a valid empty ring, so both can live in .bss
+// without a constructor.
+
+#define RING_CACHE_LINE 64
+
+// One producer, one consumer. Neither side takes a lock or disables
+// interrupts: an IRQ handler can push while the code it interrupted pops.
+template <typename T, uint32_t N>
+class SpscRing {
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "ring size must be a power of two");
+
+public:
+    // Producer side
+    bool push(const T& item) {
+        uint32_t head = head_;
+        if (head - producer_tail_ == N) {
+            producer_tail_ = __atomic_load_n(&tail_, __ATOMIC_ACQUIRE);
+            if (head - producer_tail_ == N) return false;
+        }
+        slots_[head & (N - 1)] = item;
+        __atomic_store_n(&head_, head + 1, __ATOMIC_RELEASE);
+        return true;
+    }
+
+    // Pushes as many of the items as fit and publishes them all at once.
+    // Returns how many were taken.
+    uint32_t push_bulk(const T* items, uint32_t count) {
+        uint32_t head = head_;
+        uint32_t space = N - (head - producer_tail_);
+        if (space < count) {
+            producer_tail_ = __atomic_load_n(&tail_, __ATOMIC_ACQUIRE);
+            space = N - (head - producer_tail_);
+        }
+        if (count > space) count = space;
+        for (uint32_t i = 0; i < count; i++) {
+            slots_[(head + i) & (N - 1)] = items[i];
+        }
+        __atomic_store_n(&head_, head + count, __ATOMIC_RELEASE);
+        return count;
+    }
+
+    bool full() const {
+        return head_ - __atomic_load_n(&tail_, __ATOMIC_ACQUIRE) == N;
+    }
+
+    // Consumer side
+    bool pop(T* item) {
+        uint32_t tail = tail_;
+        if (tail == consumer_head_) {
+            consumer_head_ = __atomic_load_n(&head_, __ATOMIC_ACQUIRE);
+            if (tail == consumer_head_) return false;
+        }
+        *item = slots_[tail & (N - 1)];
+        __atomic_store_n(&tail_, tail + 1, __ATOMIC_RELEASE);
+        return true;
+    }
+
+    // Takes up to max items and frees their slots at once. Returns how
+    // many were taken.
+    uint32_t pop_bulk(T* items, uint32_t max) {
+        uint32_t tail = tail_;
+        uint32_t ready = consumer_head_ - tail;
+        if (ready < max) {
+            consumer_head_ = __atomic_load_n(&head_, __ATOMIC_ACQUIRE);
+            ready = consumer_head_ - tail;
+        }
+        if (max > ready) max = ready;
+        for (uint32_t i = 0; i < max; i++) {
+            items[i] = slots_[(tail + i) & (N - 1)];
+        }
+        __atomic_store_n(&tail_, tail + max, __ATOMIC_RELEASE);
+        return max;
+    }
+
+    bool empty() const {
+        return tail_ == __atomic_load_n(&head_, __ATOMIC_ACQUIRE);
+    }
+
+    // Drops everything pushed so far
+    void clear() {
+        consumer_head_ = __atomic_load_n(&head_, __ATOMIC_ACQUIRE);
+        __atomic_store_n(&tail_, consumer_head_, __ATOMIC_RELEASE);
+    }
+
+    // Either side; only a snapshot while the other side is running
+    uint32_t size() const {
+        return __atomic_load_n(&head_, __ATOMIC_ACQUIRE) - __atomic_load_n(&tail_, __ATOMIC_ACQUIRE);
+    }
+
+    static constexpr uint32_t capacity() { return N; }
+
+private:
+    alignas(RING_CACHE_LINE) uint32_t head_;    // written by the producer
+    uint32_t producer_tail_;                    // producer's copy of tail_
+    alignas(RING_CACHE_LINE) uint32_t tail_;    // written by the consumer
+    uint32_t consumer_head_;                    // consumer's copy of head_
+    alignas(RING_CACHE_LINE) T slots_[N];
+};
+
+// Any number of producers, one consumer. Producers claim a position by
+// compare-and-swap on the head and then fill it; each slot carries a
+// sequence number that tells the consumer when its item is published and
+// tells producers when the consumer is done with it. A producer stalled
+// between claiming and publishing holds up the consumer at that slot, so
+// producers that can be interrupted by another producer on the same CPU
+// must push with interrupts off.
+template <typename T, uint32_t N>
+class MpscRing {
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "ring size must be a power of two");
+
+public:
+    // Producer side, any CPU
+    bool push(const T& item) {
+        uint32_t head = __atomic_load_n(&head_, __ATOMIC_RELAXED);
+        for (;;) {
+            slot& s = slots_[head & (N - 1)];
+            int32_t distance = (int32_t)(sequence(s, head) - head);
+            if (distance == 0) {
+                if (__atomic_compare_exchange_n(&head_, &head, head + 1, true,
+                                                __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                    s.item = item;
+                    publish(s, head, head + 1);
+                    return true;
+                }
+            } else if (distance < 0) {
+                return false;    // the consumer has not freed this slot yet
+            } else {
+                head = __atomic_load_n(&head_, __ATOMIC_RELAXED);
+            }
+        }
+    }
+
+    // Claims a run of consecutive positions with one compare-and-swap, so
+    // the items stay together even with other producers running. Returns
+    // how many were taken.
+    uint32_t push_bulk(const T* items, uint32_t count) {
+        uint32_t head = __atomic_load_n(&head_, __ATOMIC_RELAXED);
+        uint32_t claimed;
+        do {
+            // The consumer frees slots in order before advancing tail_, so
+            // everything below tail_ + N is free
+            int32_t space = (int32_t)(__atomic_load_n(&tail_, __ATOMIC_ACQUIRE) + N - head);
+            if (space <= 0) return 0;
+            claimed = (uint32_t)space < count ? (uint32_t)space : count;
+        } while (!__atomic_compare_exchange_n(&head_, &head, head + claimed, false,
+                                              __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+        for (uint32_t i = 0; i < claimed; i++) {
+            slot& s = slots_[(head + i) & (N - 1)];
+            s.item = items[i];
+            publish(s, head + i, head + i + 1);
+        }
+        return claimed;
+    }
+
+    // Consumer side
+    bool pop(T* item) {
+        uint32_t tail = tail_;
+        slot& s = slots_[tail & (N - 1)];
+        if (sequence(s, tail) != tail + 1) return false;
+        *item = s.item;
+        publish(s, tail, tail + N);
+        __atomic_store_n(&tail_, tail + 1, __ATOMIC_RELEASE);
+        return true;
+    }
+
+    // Stops at the first slot not yet published, even if later ones are
+    uint32_t pop_bulk(T* items, uint32_t max) {
+        uint32_t tail = tail_;
+        uint32_t count = 0;
+        while (count < max) {
+            slot& s = slots_[tail & (N - 1)];
+            if (sequence(s, tail) != tail + 1) break;
+            items[count++] = s.item;
+            publish(s, tail, tail + N);
+            tail++;
+        }
+        __atomic_store_n(&tail_, tail, __ATOMIC_RELEASE);
+        return count;
+    }
+
+    bool empty() const {
+        uint32_t tail = tail_;
+        return sequence(slots_[tail & (N - 1)], tail) != tail + 1;
+    }
+
+    // Claimed positions, including ones still being filled
+    uint32_t size() const {
+        return __atomic_load_n(&head_, __ATOMIC_ACQUIRE) - __atomic_load_n(&tail_, __ATOMIC_ACQUIRE);
+    }
+
+    static constexpr uint32_t capacity() { return N; }
+
+private:
+    // Sequences are stored relative to the slot's first position, so that
+    // zero means "free for position index", as a fresh ring needs
+    struct slot {
+        uint32_t sequence;
+        T item;
+    };
+
+    static uint32_t sequence(const slot& s, uint32_t position) {
+        return __atomic_load_n(&s.sequence, __ATOMIC_ACQUIRE) + (position & (N - 1));
+    }
+
+    static void publish(slot& s, uint32_t position, uint32_t value) {
+        __atomic_store_n(&s.sequence, value - (position & (N - 1)), __ATOMIC_RELEASE);
+    }
+
+    alignas(RING_CACHE_LINE) uint32_t head_;    // next position to claim
+    alignas(RING_CACHE_LINE) uint32_t tail_;    // written by the consumer
+    alignas(RING_CACHE_LINE) slot slots_[N];
+};
+
+#endif
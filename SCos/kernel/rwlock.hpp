@@ -0,0 +1,132 @@
+#ifndef RWLOCK_HPP
+#define RWLOCK_HPP
+
+#include <stdint.h>
+#include "thread.hpp"
+#include "lock_stats.hpp"
+#include "../interrupt/irq.hpp"
+
+// Spinning reader-writer lock for data that is read far more often than it
+// changes. Any number of readers may hold it at once; a writer holds it
+// alone. A waiting writer stops new readers from entering, so a steady
+// stream of readers cannot starve it. Readers must not nest: a writer
+// waiting between the two acquisitions would deadlock them.
+
+#define RW_WRITER 0x80000000u
+#define RW_WRITER_WAITING 0x40000000u
+#define RW_READERS 0x3FFFFFFFu
+
+struct rwlock {
+    volatile uint32_t state;    // writer bits and the reader count
+    lock_stats* stats;
+};
+
+#define RWLOCK_INIT {0, nullptr}
+#define RWLOCK_INIT_STATS(stats) {0, (stats)}
+
+static inline __attribute__((always_inline)) void read_lock_raw(rwlock* lock) {
+#if LOCK_STATS
+    bool contended = false;
+#endif
+    for (;;) {
+        uint32_t state = lock->state;
+        if (!(state & (RW_WRITER | RW_WRITER_WAITING))) {
+            if (__atomic_compare_exchange_n(&lock->state, &state, state + 1, false,
+                                            __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+                break;
+            }
+            continue;
+        }
+#if LOCK_STATS
+        contended = true;
+#endif
+        asm volatile("pause");
+    }
+#if LOCK_STATS
+    if (lock->stats) lock_stats_shared(lock->stats, contended);
+#endif
+}
+
+static inline __attribute__((always_inline)) void read_unlock_raw(rwlock* lock) {
+    __atomic_sub_fetch(&lock->state, 1, __ATOMIC_RELEASE);
+}
+
+static inline __attribute__((always_inline)) void write_lock_raw(rwlock* lock) {
+#if LOCK_STATS
+    uint32_t start = lock->stats ? irq_cycles() : 0;
+    bool contended = false;
+#endif
+    for (;;) {
+        uint32_t state = lock->state;
+        // Free apart from, possibly, our own or another writer's waiting bit
+        if (!(state & ~RW_WRITER_WAITING)) {
+            if (__atomic_compare_exchange_n(&lock->state, &state, RW_WRITER, false,
+                                            __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+                break;
+            }
+            continue;
+        }
+        if (!(state & RW_WRITER_WAITING)) {
+            __atomic_fetch_or(&lock->state, RW_WRITER_WAITING, __ATOMIC_RELAXED);
+        }
+#if LOCK_STATS
+        contended = true;
+#endif
+        asm volatile("pause");
+    }
+#if LOCK_STATS
+    if (lock->stats) lock_stats_acquired(lock->stats, contended, start);
+#endif
+}
+
+// Clears only our bit; another writer may have set its waiting bit since
+static inline __attribute__((always_inline)) void write_unlock_raw(rwlock* lock) {
+#if LOCK_STATS
+    if (lock->stats) lock_stats_released(lock->stats);
+#endif
+    __atomic_fetch_and(&lock->state, ~RW_WRITER, __ATOMIC_RELEASE);
+}
+
+static inline void read_lock(rwlock* lock) {
+    preempt_disable();
+    read_lock_raw(lock);
+}
+
+static inline void read_unlock(rwlock* lock) {
+    read_unlock_raw(lock);
+    preempt_enable();
+}
+
+static inline void write_lock(rwlock* lock) {
+    preempt_disable();
+    write_lock_raw(lock);
+}
+
+static inline void write_unlock(rwlock* lock) {
+    write_unlock_raw(lock);
+    preempt_enable();
+}
+
+static inline __attribute__((always_inline)) uint32_t read_lock_irqsave(rwlock* lock) {
+    uint32_t flags = irq_save();
+    read_lock_raw(lock);
+    return flags;
+}
+
+static inline __attribute__((always_inline)) void read_unlock_irqrestore(rwlock* lock, uint32_t flags) {
+    read_unlock_raw(lock);
+    irq_restore(flags);
+}
+
+static inline __attribute__((always_inline)) uint32_t write_lock_irqsave(rwlock* lock) {
+    uint32_t flags = irq_save();
+    write_lock_raw(lock);
+    return flags;
+}
+
+static inline __attribute__((always_inline)) void write_unlock_irqrestore(rwlock* lock, uint32_t flags) {
+    write_unlock_raw(lock);
+    irq_restore(flags);
+}
+
+#endif
@@ -0,0 +1,75 @@
+#ifndef SEQLOCK_HPP
+#define SEQLOCK_HPP
+
+#include <stdint.h>
+#include "spinlock.hpp"
+
+// Sequence lock for small, often-read records such as a cached time.
+// Writers serialise on a spinlock and bump the sequence before and after
+// their update, so it is odd while one is in progress. Readers take no
+// lock at all: they copy the record and retry if the sequence moved.
+//
+//     uint32_t seq;
+//     do {
+//         seq = read_seqbegin(&lock);
+//         copy = record;
+//     } while (read_seqretry(&lock, seq));
+//
+// A reader can see a torn record before it retries, so it must only copy,
+// never follow pointers out of it. Readers that can interrupt a writer on
+// the same CPU would spin forever; such writers use the irqsave pair.
+
+struct seqlock {
+    volatile uint32_t sequence;
+    spinlock writer;
+};
+
+#define SEQLOCK_INIT {0, SPINLOCK_INIT}
+#define SEQLOCK_INIT_STATS(stats) {0, SPINLOCK_INIT_STATS(stats)}
+
+// x86 keeps stores in order and loads in order, so only the compiler needs
+// fencing around the record
+static inline void seqlock_barrier() {
+    asm volatile("" : : : "memory");
+}
+
+static inline uint32_t read_seqbegin(const seqlock* lock) {
+    uint32_t sequence;
+    while ((sequence = lock->sequence) & 1) {
+        asm volatile("pause");
+    }
+    seqlock_barrier();
+    return sequence;
+}
+
+static inline bool read_seqretry(const seqlock* lock, uint32_t start) {
+    seqlock_barrier();
+    return lock->sequence != start;
+}
+
+static inline void write_seqlock(seqlock* lock) {
+    spin_lock(&lock->writer);
+    lock->sequence++;
+    seqlock_barrier();
+}
+
+static inline void write_sequnlock(seqlock* lock) {
+    seqlock_barrier();
+    lock->sequence++;
+    spin_unlock(&lock->writer);
+}
+
+static inline __attribute__((always_inline)) uint32_t write_seqlock_irqsave(seqlock* lock) {
+    uint32_t flags = spin_lock_irqsave(&lock->writer);
+    lock->sequence++;
+    seqlock_barrier();
+    return flags;
+}
+
+static inline __attribute__((always_inline)) void write_sequnlock_irqrestore(seqlock* lock, uint32_t flags) {
+    seqlock_barrier();
+    lock->sequence++;
+    spin_unlock_irqrestore(&lock->writer, flags);
+}
+
+#endif
@@ -0,0 +1,642 @@
+#include "smp.hpp"
+#include "gdt.hpp"
+#include "spinlock.hpp"
+#include "thread.hpp"
+#include "../drivers/timer.hpp"
+#include "../interrupt/idt.hpp"
+#include "../interrupt/irq.hpp"
+#include "../memory/heap.hpp"
+#include "../memory/paging.hpp"
+#include "../memory/pmm.hpp"
+#include "../debug/log.hpp"
+#include "../debug/serial.hpp"
+#include "../include/stddef.h"
+#include "../include/memory.h"
+
+// Local APIC registers, as offsets from its MMIO base
+#define LAPIC_ID 0x020
+#define LAPIC_EOI 0x0B0
+#define LAPIC_SVR 0x0F0
+#define LAPIC_ICR_LOW 0x300
+#define LAPIC_ICR_HIGH 0x310
+#define LAPIC_LVT_LINT0 0x350
+#define LAPIC_LVT_LINT1 0x360
+
+#define LAPIC_SVR_ENABLE 0x100
+#define APIC_MASKED 0x10000
+#define LVT_EXTINT 0x700
+#define LVT_NMI 0x400
+
+#define ICR_FIXED 0x000
+#define ICR_INIT 0x500
+#define ICR_STARTUP 0x600
+#define ICR_PENDING 0x1000
+#define ICR_ASSERT 0x4000
+#define ICR_LEVEL 0x8000
+#define ICR_ALL_BUT_SELF 0xC0000
+
+#define IOAPIC_REGSEL 0x00
+#define IOAPIC_WINDOW 0x10
+#define IOAPIC_VERSION 0x01
+#define IOAPIC_REDIRECTION 0x10
+
+// Where the BIOS data area keeps the EBDA segment, and the ROM area the
+// firmware tables may live in instead
+#define BIOS_EBDA_SEGMENT 0x40E
+#define BIOS_ROM_BASE 0xE0000
+#define BIOS_ROM_SIZE 0x20000
+
+#define MADT_LAPIC 0
+#define MADT_IOAPIC 1
+#define MADT_LAPIC_ENABLED 0x01
+
+#define MP_PROCESSOR 0
+#define MP_IOAPIC 2
+#define MP_PROCESSOR_SIZE 20
+#define MP_ENTRY_SIZE 8
+#define MP_ENABLED 0x01
+
+#define AP_STACK_SIZE (16 * 1024)
+#define AP_INIT_DELAY_MS 10
+#define AP_SIPI_DELAY_US 200
+#define AP_START_TIMEOUT_MS 100
+// ap_boot_index once an AP has taken it, or once a timed-out start has
+// been given up on
+#define AP_BOOT_CLAIMED 0xFFFFFFFF
+
+#define SMP_QUEUE_MASK (SMP_QUEUE_SIZE - 1)
+
+struct acpi_rsdp {
+    char signature[8];
+    uint8_t checksum;
+    char oem[6];
+    uint8_t revision;
+    uint32_t rsdt;
+} __attribute__((packed));
+
+struct acpi_header {
+    char signature[4];
+    uint32_t length;
+    uint8_t revision;
+    uint8_t checksum;
+    char oem[6];
+    char oem_table[8];
+    uint32_t oem_revision;
+    uint32_t creator;
+    uint32_t creator_revision;
+} __attribute__((packed));
+
+struct acpi_madt {
+    acpi_header header;
+    uint32_t lapic_address;
+    uint32_t flags;
+} __attribute__((packed));
+
+struct mp_floating {
+    char signature[4];
+    uint32_t config;
+    uint8_t length;             // in 16-byte units
+    uint8_t revision;
+    uint8_t checksum;
+    uint8_t features[5];        // features[0] != 0 means a default config
+} __attribute__((packed));
+
+struct mp_config {
+    char signature[4];
+    uint16_t length;
+    uint8_t revision;
+    uint8_t checksum;
+    char oem[8];
+    char product[12];
+    uint32_t oem_table;
+    uint16_t oem_size;
+    uint16_t entry_count;
+    uint32_t lapic_address;
+    uint16_t ext_length;
+    uint8_t ext_checksum;
+    uint8_t reserved;
+} __attribute__((packed));
+
+struct smp_job {
+    smp_job_fn fn;
+    void* arg;
+    fiber_event* done;
+};
+
+// Free-running indices: the owner pushes and pops at tail, thieves take
+// from head
+struct job_queue {
+    spinlock lock;
+    volatile uint32_t head;
+    volatile uint32_t tail;
+    smp_job jobs[SMP_QUEUE_SIZE];
+};
+
+cpu_info cpus[MAX_CPUS];
+
+static uint32_t cpu_count = 1;
+static volatile uint32_t online_count = 1;
+static uint32_t lapic_base = 0;
+static uint32_t ioapic_base = 0;
+static uint32_t ioapic_pins = 0;
+static const char* table_source = "none";
+
+static job_queue queues[MAX_CPUS];
+// APs halted waiting for work, one bit per CPU index
+static volatile uint32_t idle_mask = 0;
+static volatile uint32_t next_target = 0;
+
+static lock_stats tlb_lock_stats = LOCK_STATS_INIT("tlb");
+static spinlock tlb_lock = SPINLOCK_INIT_STATS(&tlb_lock_stats);
+static volatile uint32_t tlb_flush_addr = 0;
+static volatile uint32_t tlb_pending = 0;
+static uint32_t tlb_shootdowns = 0;
+
+// Handed to one AP at a time while it starts. They are never reused while
+// an earlier AP could still be starting: see start_ap.
+extern "C" {
+    volatile uint32_t ap_boot_cr3 = 0;
+    volatile uint32_t ap_boot_stack = 0;
+    volatile uint32_t ap_boot_index = 0;
+
+    extern uint8_t ap_trampoline_start[];
+    extern uint8_t ap_trampoline_end[];
+    extern uint32_t _kernel_end;
+}
+
+static inline uint32_t lapic_read(uint32_t reg) {
+    return *(volatile uint32_t*)(lapic_base + reg);
+}
+
+static inline void lapic_write(uint32_t reg, uint32_t value) {
+    *(volatile uint32_t*)(lapic_base + reg) = value;
+}
+
+// An interrupt handler sending an IPI between the two ICR writes would
+// redirect this one, so the pair runs with interrupts off
+static void lapic_send_ipi(uint32_t apic_id, uint32_t command) {
+    uint32_t flags = irq_save();
+    lapic_write(LAPIC_ICR_HIGH, apic_id << 24);
+    lapic_write(LAPIC_ICR_LOW, command);
+    while (lapic_read(LAPIC_ICR_LOW) & ICR_PENDING) {
+        asm volatile("pause");
+    }
+    irq_restore(flags);
+}
+
+// Only the BSP takes 8259 interrupts, through LINT0 in virtual-wire mode
+static void lapic_enable(bool bsp) {
+    lapic_write(LAPIC_SVR, LAPIC_SVR_ENABLE | LAPIC_SPURIOUS_VECTOR);
+    lapic_write(LAPIC_LVT_LINT0, bsp ? LVT_EXTINT : APIC_MASKED);
+    lapic_write(LAPIC_LVT_LINT1, bsp ? LVT_NMI : APIC_MASKED);
+}
+
+static uint32_t ioapic_read(uint32_t reg) {
+    *(volatile uint32_t*)(ioapic_base + IOAPIC_REGSEL) = reg;
+    return *(volatile uint32_t*)(ioapic_base + IOAPIC_WINDOW);
+}
+
+static void ioapic_write(uint32_t reg, uint32_t value) {
+    *(volatile uint32_t*)(ioapic_base + IOAPIC_REGSEL) = reg;
+    *(volatile uint32_t*)(ioapic_base + IOAPIC_WINDOW) = value;
+}
+
+static bool map_registers(uint32_t phys) {
+    return paging_map_page(phys, phys, PAGE_WRITABLE | PAGE_NOCACHE);
+}
+
+static bool checksum_ok(const void* table, uint32_t length) {
+    const uint8_t* bytes = (const uint8_t*)table;
+    uint8_t sum = 0;
+    for (uint32_t i = 0; i < length; i++) {
+        sum += bytes[i];
+    }
+    return sum == 0;
+}
+
+static const void* scan_range(uint32_t base, uint32_t size, const char* signature,
+                              uint32_t signature_length, uint32_t table_length) {
+    for (uint32_t addr = base; addr + table_length <= base + size; addr += 16) {
+        if (memcmp((const void*)addr, signature, signature_length) == 0 &&
+            checksum_ok((const void*)addr, table_length)) {
+            return (const void*)addr;
+        }
+    }
+    return nullptr;
+}
+
+// Both table roots sit on a 16-byte boundary in the EBDA's first KB or in
+// the BIOS ROM area
+static const void* scan_bios(const char* signature, uint32_t signature_length, uint32_t table_length) {
+    uint32_t ebda = *(volatile uint16_t*)BIOS_EBDA_SEGMENT << 4;
+    const void* found = nullptr;
+    if (ebda) {
+        found = scan_range(ebda, 1024, signature, signature_length, table_length);
+    }
+    if (!found) {
+        found = scan_range(BIOS_ROM_BASE, BIOS_ROM_SIZE, signature, signature_length, table_length);
+    }
+    return found;
+}
+
+static const acpi_madt* find_madt() {
+    const acpi_rsdp* rsdp = (const acpi_rsdp*)scan_bios("RSD PTR ", 8, sizeof(acpi_rsdp));
+    if (!rsdp || !rsdp->rsdt) return nullptr;
+
+    const acpi_header* rsdt = (const acpi_header*)rsdp->rsdt;
+    if (memcmp(rsdt->signature, "RSDT", 4) != 0 || !checksum_ok(rsdt, rsdt->length)) {
+        return nullptr;
+    }
+
+    const uint32_t* tables = (const uint32_t*)(rsdt + 1);
+    uint32_t count = (rsdt->length - sizeof(acpi_header)) / sizeof(uint32_t);
+    for (uint32_t i = 0; i < count; i++) {
+        const acpi_header* table = (const acpi_header*)tables[i];
+        if (memcmp(table->signature, "APIC", 4) == 0 && checksum_ok(table, table->length)) {
+            return (const acpi_madt*)table;
+        }
+    }
+    return nullptr;
+}
+
+static const mp_config* find_mp_config() {
+    const mp_floating* floating = (const mp_floating*)scan_bios("_MP_", 4, sizeof(mp_floating));
+    // A default configuration has no table to walk
+    if (!floating || !floating->config || floating->features[0]) return nullptr;
+
+    const mp_config* config = (const mp_config*)floating->config;
+    if (memcmp(config->signature, "PCMP", 4) != 0 || !checksum_ok(config, config->length)) {
+        return nullptr;
+    }
+    return config;
+}
+
+static void add_cpu(uint32_t apic_id) {
+    // The BSP is already cpus[0]
+    if (apic_id == cpus[0].apic_id) return;
+
+    if (cpu_count == MAX_CPUS) {
+        log_warn(LOG_KERNEL, "Ignoring CPU with APIC ID %u, MAX_CPUS is %d\n", apic_id, MAX_CPUS);
+        return;
+    }
+    cpus[cpu_count++].apic_id = apic_id;
+}
+
+// Returns the first IOAPIC's address, or 0
+static uint32_t parse_madt(const acpi_madt* madt) {
+    uint32_t ioapic = 0;
+    const uint8_t* entry = (const uint8_t*)(madt + 1);
+    const uint8_t* end = (const uint8_t*)madt + madt->header.length;
+
+    while (entry + 2 <= end && entry[1] >= 2) {
+        if (entry[0] == MADT_LAPIC && (*(const uint32_t*)(entry + 4) & MADT_LAPIC_ENABLED)) {
+            add_cpu(entry[3]);
+        } else if (entry[0] == MADT_IOAPIC && !ioapic) {
+            ioapic = *(const uint32_t*)(entry + 4);
+        }
+        entry += entry[1];
+    }
+    return ioapic;
+}
+
+static uint32_t parse_mp_config(const mp_config* config) {
+    uint32_t ioapic = 0;
+    const uint8_t* entry = (const uint8_t*)(config + 1);
+
+    for (uint32_t i = 0; i < config->entry_count; i++) {
+        if (entry[0] == MP_PROCESSOR) {
+            if (entry[3] & MP_ENABLED) add_cpu(entry[1]);
+            entry += MP_PROCESSOR_SIZE;
+        } else {
+            if (entry[0] == MP_IOAPIC && (entry[3] & MP_ENABLED) && !ioapic) {
+                ioapic = *(const uint32_t*)(entry + 4);
+            }
+            entry += MP_ENTRY_SIZE;
+        }
+    }
+    return ioapic;
+}
+
+// Device interrupts keep arriving through the 8259, so the IOAPIC only
+// needs every redirection entry masked
+static void init_ioapic(uint32_t phys) {
+    if (!phys || !map_registers(phys)) return;
+
+    ioapic_base = phys;
+    ioapic_pins = ((ioapic_read(IOAPIC_VERSION) >> 16) & 0xFF) + 1;
+    for (uint32_t pin = 0; pin < ioapic_pins; pin++) {
+        ioapic_write(IOAPIC_REDIRECTION + pin * 2, APIC_MASKED);
+        ioapic_write(IOAPIC_REDIRECTION + pin * 2 + 1, 0);
+    }
+}
+
+static bool pop_job(job_queue* queue, smp_job* job, bool newest) {
+    spin_lock(&queue->lock);
+    bool found = queue->head != queue->tail;
+    if (found) {
+        if (newest) {
+            queue->tail--;
+            *job = queue->jobs[queue->tail & SMP_QUEUE_MASK];
+        } else {
+            *job = queue->jobs[queue->head & SMP_QUEUE_MASK];
+            queue->head++;
+        }
+    }
+    spin_unlock(&queue->lock);
+    return found;
+}
+
+static bool next_job(uint32_t self, smp_job* job) {
+    if (pop_job(&queues[self], job, true)) return true;
+
+    for (uint32_t i = 1; i < cpu_count; i++) {
+        uint32_t victim = (self + i) % cpu_count;
+        if (pop_job(&queues[victim], job, false)) {
+            cpus[self].jobs_stolen++;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Unlocked peek; a stale answer only costs one more pass
+static bool work_queued() {
+    for (uint32_t i = 0; i < cpu_count; i++) {
+        if (queues[i].head != queues[i].tail) return true;
+    }
+    return false;
+}
+
+static void run_job(uint32_t self, const smp_job* job) {
+    job->fn(job->arg);
+    cpus[self].jobs_run++;
+    if (job->done) fiber_signal(job->done);
+}
+
+// Jobs run with interrupts on so wake-ups and TLB shootdowns are taken
+// even mid-job; nothing else is routed to an AP
+static void ap_worker(uint32_t self) __attribute__((noreturn));
+static void ap_worker(uint32_t self) {
+    asm volatile("sti");
+    for (;;) {
+        smp_job job;
+        if (next_job(self, &job)) {
+            run_job(self, &job);
+            continue;
+        }
+
+        // Go idle before the last look, so a submitter that finds the bit
+        // clear has queued work this check will see. A wake IPI arriving
+        // after it stays pending until sti, whose one-instruction delay
+        // means it then ends the hlt rather than preceding it.
+        asm volatile("cli");
+        __atomic_or_fetch(&idle_mask, 1u << self, __ATOMIC_SEQ_CST);
+        if (work_queued()) {
+            asm volatile("sti");
+        } else {
+            asm volatile("sti\n\thlt" : : : "memory");
+        }
+        __atomic_and_fetch(&idle_mask, ~(1u << self), __ATOMIC_SEQ_CST);
+    }
+}
+
+extern "C" void ap_main() {
+    // An AP that arrives after start_ap gave up on it finds the index
+    // already claimed and stays halted on its own stack
+    uint32_t index = __atomic_exchange_n(&ap_boot_index, AP_BOOT_CLAIMED, __ATOMIC_ACQ_REL);
+    if (index == AP_BOOT_CLAIMED) {
+        for (;;) {
+            asm volatile("cli\n\thlt");
+        }
+    }
+
+    gdt_load_cpu(index);
+    idt_reload();
+    lapic_enable(false);
+
+    __atomic_add_fetch(&online_count, 1, __ATOMIC_SEQ_CST);
+    __atomic_store_n(&cpus[index].online, true, __ATOMIC_RELEASE);
+    ap_worker(index);
+}
+
+// Without APs the BSP runs the jobs itself. It wakes on every interrupt,
+// so a job waits at most one tick to start.
+static void bsp_worker(void*) {
+    for (;;) {
+        smp_job job;
+        if (next_job(0, &job)) {
+            run_job(0, &job);
+        } else {
+            thread_wait_interrupt();
+        }
+    }
+}
+
+static void wake_ipi(interrupt_frame*) {
+    lapic_write(LAPIC_EOI, 0);
+}
+
+static void tlb_ipi(interrupt_frame*) {
+    asm volatile("invlpg (%0)" : : "r"(tlb_flush_addr) : "memory");
+    __atomic_sub_fetch(&tlb_pending, 1, __ATOMIC_RELEASE);
+    lapic_write(LAPIC_EOI, 0);
+}
+
+// A spurious LAPIC interrupt must not be acknowledged
+static void lapic_spurious(interrupt_frame*) {
+}
+
+// The startup IPI can only name a page below 1 MB, so the trampoline goes
+// to a fixed page that init_pmm reserves for it
+static uint32_t install_trampoline() {
+    uint32_t size = ap_trampoline_end - ap_trampoline_start;
+    if ((uint32_t)&_kernel_end > AP_TRAMPOLINE_ADDR || size > PAGE_SIZE) {
+        log_error(LOG_KERNEL, "No room at 0x%x for the AP trampoline\n", AP_TRAMPOLINE_ADDR);
+        return 0;
+    }
+
+    memcpy((void*)AP_TRAMPOLINE_ADDR, ap_trampoline_start, size);
+    return AP_TRAMPOLINE_ADDR;
+}
+
+// INIT, then a startup IPI and a second one if the first went unnoticed,
+// as the MP spec asks
+static bool start_ap(uint32_t index, uint32_t trampoline) {
+    cpu_info* cpu = &cpus[index];
+
+    // Touched now, since the AP cannot take a demand fault before its IDT
+    // is loaded
+    uint8_t* stack = (uint8_t*)kmalloc(AP_STACK_SIZE);
+    if (!stack) {
+        log_error(LOG_KERNEL, "No memory for the stack of CPU %u\n", index);
+        return false;
+    }
+    memset(stack, 0, AP_STACK_SIZE);
+
+    uint32_t cr3;
+    asm volatile("mov %%cr3, %0" : "=r"(cr3));
+    ap_boot_cr3 = cr3;
+    ap_boot_stack = (uint32_t)(stack + AP_STACK_SIZE);
+    ap_boot_index = index;
+
+    lapic_send_ipi(cpu->apic_id, ICR_INIT | ICR_ASSERT | ICR_LEVEL);
+    ksleep_ms(AP_INIT_DELAY_MS);
+    for (int attempt = 0; attempt < 2 && !cpu->online; attempt++) {
+        lapic_send_ipi(cpu->apic_id, ICR_STARTUP | ICR_ASSERT | (trampoline >> 12));
+        ksleep_until(ktime_ns() + AP_SIPI_DELAY_US * 1000);
+    }
+
+    uint64_t deadline = ktime_deadline_ms(AP_START_TIMEOUT_MS);
+    while (!cpu->online && !ktime_expired(deadline)) {
+        asm volatile("pause");
+    }
+
+    // A late AP would still boot on this stack and read ap_boot_index, so
+    // claim the index first. If the AP already took it, it is past the
+    // trampoline and only has its GDT, IDT and LAPIC left to set up.
+    if (!cpu->online) {
+        if (__atomic_exchange_n(&ap_boot_index, AP_BOOT_CLAIMED, __ATOMIC_ACQ_REL) != AP_BOOT_CLAIMED) {
+            // The stack stays allocated: the AP may still arrive and halt on it
+            log_warn(LOG_KERNEL, "CPU with APIC ID %u did not start\n", cpu->apic_id);
+            return false;
+        }
+        while (!__atomic_load_n(&cpu->online, __ATOMIC_ACQUIRE)) {
+            asm volatile("pause");
+        }
+    }
+    return true;
+}
+
+static bool start_bsp_worker() {
+    if (!thread_create("smp-worker", bsp_worker, nullptr, THREAD_PRIORITY_LOW)) {
+        return false;
+    }
+    log_info(LOG_KERNEL, "SMP: 1 CPU, jobs run on the BSP\n");
+    return true;
+}
+
+bool init_smp() {
+    cpus[0].online = true;
+
+    // Startup delays are timed against the TSC with interrupts still off
+    if (!tsc_khz()) {
+        log_warn(LOG_KERNEL, "SMP: no TSC to time AP startup\n");
+        return start_bsp_worker();
+    }
+
+    const acpi_madt* madt = find_madt();
+    const mp_config* mp = madt ? nullptr : find_mp_config();
+    if (!madt && !mp) {
+        return start_bsp_worker();
+    }
+
+    uint32_t lapic_phys = madt ? madt->lapic_address : mp->lapic_address;
+    if (!map_registers(lapic_phys)) {
+        log_error(LOG_KERNEL, "SMP: cannot map the local APIC at 0x%x\n", lapic_phys);
+        return start_bsp_worker();
+    }
+    lapic_base = lapic_phys;
+    cpus[0].apic_id = lapic_read(LAPIC_ID) >> 24;
+    table_source = madt ? "ACPI MADT" : "MP table";
+
+    uint32_t ioapic_phys = madt ? parse_madt(madt) : parse_mp_config(mp);
+    init_ioapic(ioapic_phys);
+
+    register_interrupt_handler(SMP_WAKE_VECTOR, wake_ipi);
+    register_interrupt_handler(SMP_TLB_VECTOR, tlb_ipi);
+    register_interrupt_handler(LAPIC_SPURIOUS_VECTOR, lapic_spurious);
+    lapic_enable(true);
+
+    uint32_t trampoline = cpu_count > 1 ? install_trampoline() : 0;
+    // A CPU that fails to start may still run the trampoline later, so the
+    // boot globals are not handed to another one after it
+    for (uint32_t i = 1; trampoline && i < cpu_count; i++) {
+        if (!start_ap(i, trampoline)) break;
+    }
+
+    if (online_count == 1) {
+        return start_bsp_worker();
+    }
+    log_info(LOG_KERNEL, "SMP: %u of %u CPUs online (%s), IOAPIC with %u pins\n",
+             online_count, cpu_count, table_source, ioapic_pins);
+    return true;
+}
+
+uint32_t smp_cpu_count() {
+    return online_count;
+}
+
+// Jobs from a job stay local; the BSP deals them round-robin to the APs
+static uint32_t pick_queue() {
+    uint32_t self = smp_cpu_id();
+    if (self != 0 || online_count == 1) return self;
+
+    for (;;) {
+        uint32_t index = 1 + __atomic_fetch_add(&next_target, 1, __ATOMIC_RELAXED) % (cpu_count - 1);
+        if (cpus[index].online) return index;
+    }
+}
+
+// A busy target will get to the job eventually, but an idle CPU can steal
+// it now
+static void wake_worker(uint32_t target) {
+    if (target == 0) return;
+
+    uint32_t idle = __atomic_load_n(&idle_mask, __ATOMIC_SEQ_CST);
+    if (!(idle & (1u << target))) {
+        if (!idle) return;
+        target = __builtin_ctz(idle);
+    }
+    lapic_send_ipi(cpus[target].apic_id, ICR_FIXED | ICR_ASSERT | SMP_WAKE_VECTOR);
+}
+
+bool smp_submit(smp_job_fn fn, void* arg, fiber_event* done) {
+    if (done) fiber_event_init(done);
+
+    uint32_t target = pick_queue();
+    job_queue* queue = &queues[target];
+
+    spin_lock(&queue->lock);
+    bool queued = queue->tail - queue->head < SMP_QUEUE_SIZE;
+    if (queued) {
+        smp_job* job = &queue->jobs[queue->tail & SMP_QUEUE_MASK];
+        job->fn = fn;
+        job->arg = arg;
+        job->done = done;
+        queue->tail++;
+    }
+    spin_unlock(&queue->lock);
+
+    if (queued) wake_worker(target);
+    return queued;
+}
+
+// Shootdowns are rare (the heap handing pages back), so one at a time is
+// enough. The other CPUs must have interrupts on to answer, which is why
+// the caller must not hold a lock they could be spinning on with
+// interrupts off.
+void smp_flush_tlb(uint32_t virt) {
+    uint32_t others = online_count - 1;
+    if (!others) return;
+
+    spin_lock(&tlb_lock);
+    tlb_flush_addr = virt;
+    __atomic_store_n(&tlb_pending, others, __ATOMIC_SEQ_CST);
+    lapic_send_ipi(0, ICR_FIXED | ICR_ASSERT | ICR_ALL_BUT_SELF | SMP_TLB_VECTOR);
+    while (__atomic_load_n(&tlb_pending, __ATOMIC_ACQUIRE)) {
+        asm volatile("pause");
+    }
+    tlb_shootdowns++;
+    spin_unlock(&tlb_lock);
+}
+
+void smp_stats() {
+    serial_printf("SMP - %u of %u CPUs online (%s), %u TLB shootdowns\n",
+                  online_count, cpu_count, table_source, tlb_shootdowns);
+    for (uint32_t i = 0; i < cpu_count; i++) {
+        cpu_info* cpu = &cpus[i];
+        serial_printf("  CPU %u: APIC ID %u, %s, %u jobs run, %u stolen, %u queued\n",
+                      i, cpu->apic_id, cpu->online ? "online" : "offline",
+                      cpu->jobs_run, cpu->jobs_stolen, queues[i].tail - queues[i].head);
+    }
+}
@@ -0,0 +1,44 @@
+#ifndef SMP_HPP
+#define SMP_HPP
+
+#include <stdint.h>
+#include "percpu.hpp"
+#include "fiber.hpp"
+
+// Symmetric multiprocessing. The BSP finds the other CPUs in the ACPI
+// MADT, or the MP table on older firmware, and starts them with
+// INIT-SIPI-SIPI. Threads, device interrupts and the desktop stay on the
+// BSP; the APs run background jobs.
+//
+// Each CPU has its own job deque. A CPU runs the jobs queued on it newest
+// first, and once its own deque is empty it steals the oldest job from
+// another, so a burst of work spreads over every core without one shared
+// queue. Idle APs halt until an IPI says there is work.
+
+#define SMP_QUEUE_SIZE 64
+#define SMP_WAKE_VECTOR 0xF0
+#define SMP_TLB_VECTOR 0xF1
+#define LAPIC_SPURIOUS_VECTOR 0xFF
+
+typedef void (*smp_job_fn)(void* arg);
+
+// Needs paging, the heap, the timer and threads. With one CPU, or if no AP
+// comes up, jobs run on a low-priority BSP thread instead, so callers
+// never need to care how many cores there are.
+bool init_smp();
+// CPUs running, the BSP included
+uint32_t smp_cpu_count();
+
+// Queues fn(arg) on another core and signals `done`, if given, once it
+// has run; a fiber waits for it with fiber_await_io. A job submitted from
+// a job stays on that core unless an idle one steals it. Jobs may allocate
+// and log, but must not sleep or touch desktop state. Returns false when
+// the queue is full.
+bool smp_submit(smp_job_fn fn, void* arg, fiber_event* done);
+
+// Drops virt from every other CPU's TLB and waits until they have; paging
+// calls it whenever it removes a mapping
+void smp_flush_tlb(uint32_t virt);
+void smp_stats();
+
+#endif
@@ -0,0 +1,98 @@
+#ifndef SPINLOCK_HPP
+#define SPINLOCK_HPP
+
+#include <stdint.h>
+#include "thread.hpp"
+#include "lock_stats.hpp"
+#include "../interrupt/irq.hpp"
+
+// Ticket lock for data shared between CPUs. Each waiter takes the next
+// ticket and spins until the lock serves it, so CPUs get the lock in the
+// order they asked and none can starve under contention.
+//
+// spin_lock also disables preemption, so a holder on the BSP is never
+// switched out while an AP waits on it. Data an interrupt handler also
+// touches needs the irqsave pair, or the handler could spin on a lock its
+// own CPU already holds.
+
+struct spinlock {
+    volatile uint16_t owner;    // ticket being served
+    volatile uint16_t next;     // next ticket to hand out
+    lock_stats* stats;
+};
+
+#define SPINLOCK_INIT {0, 0, nullptr}
+#define SPINLOCK_INIT_STATS(stats) {0, 0, (stats)}
+
+static inline __attribute__((always_inline)) void spin_lock_raw(spinlock* lock) {
+    uint16_t ticket = __atomic_fetch_add(&lock->next, 1, __ATOMIC_RELAXED);
+#if LOCK_STATS
+    uint32_t start = lock->stats ? irq_cycles() : 0;
+    bool contended = false;
+#endif
+    while (__atomic_load_n(&lock->owner, __ATOMIC_ACQUIRE) != ticket) {
+#if LOCK_STATS
+        contended = true;
+#endif
+        asm volatile("pause");
+    }
+#if LOCK_STATS
+    if (lock->stats) lock_stats_acquired(lock->stats, contended, start);
+#endif
+}
+
+static inline __attribute__((always_inline)) bool spin_trylock_raw(spinlock* lock) {
+    uint16_t owner = __atomic_load_n(&lock->owner, __ATOMIC_RELAXED);
+    uint16_t ticket = owner;
+    // Only take a ticket if it would be served at once
+    if (!__atomic_compare_exchange_n(&lock->next, &ticket, (uint16_t)(owner + 1), false,
+                                     __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+        return false;
+    }
+#if LOCK_STATS
+    if (lock->stats) lock_stats_acquired(lock->stats, false, 0);
+#endif
+    return true;
+}
+
+static inline __attribute__((always_inline)) void spin_unlock_raw(spinlock* lock) {
+#if LOCK_STATS
+    if (lock->stats) lock_stats_released(lock->stats);
+#endif
+    // Only the holder writes owner
+    __atomic_store_n(&lock->owner, (uint16_t)(lock->owner + 1), __ATOMIC_RELEASE);
+}
+
+static inline bool spin_is_locked(const spinlock* lock) {
+    return lock->owner != lock->next;
+}
+
+static inline void spin_lock(spinlock* lock) {
+    preempt_disable();
+    spin_lock_raw(lock);
+}
+
+static inline bool spin_trylock(spinlock* lock) {
+    preempt_disable();
+    if (spin_trylock_raw(lock)) return true;
+    preempt_enable();
+    return false;
+}
+
+static inline void spin_unlock(spinlock* lock) {
+    spin_unlock_raw(lock);
+    preempt_enable();
+}
+
+static inline __attribute__((always_inline)) uint32_t spin_lock_irqsave(spinlock* lock) {
+    uint32_t flags = irq_save();
+    spin_lock_raw(lock);
+    return flags;
+}
+
+static inline __attribute__((always_inline)) void spin_unlock_irqrestore(spinlock* lock, uint32_t flags) {
+    spin_unlock_raw(lock);
+    irq_restore(flags);
+}
+
+#endif
@@ -0,0 +1,20 @@
+global switch_context
+
+; void switch_context(uint32_t* save_esp, uint32_t load_esp)
+; Pushes the callee-saved registers, stores the stack pointer through
+; save_esp and resumes the thread whose stack load_esp points at. The
+; caller-saved registers are already dead across the call.
+switch_context:
+    mov eax, [esp+4]
+    mov edx, [esp+8]
+    push ebp
+    push ebx
+    push esi
+    push edi
+    mov [eax], esp
+    mov esp, edx
+    pop edi
+    pop esi
+    pop ebx
+    pop ebp
+    ret
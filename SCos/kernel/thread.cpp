@@ -0,0 +1,321 @@
+#include "thread.hpp"
+#include "percpu.hpp"
+#include "../drivers/timer.hpp"
+#include "../interrupt/irq.hpp"
+#include "../memory/heap.hpp"
+#include "../debug/log.hpp"
+#include "../debug/serial.hpp"
+#include "../include/kernel.h"
+#include "../include/memory.h"
+
+// Written at the bottom of every allocated stack and checked whenever its
+// thread is switched out
+#define STACK_CANARY 0x5C05DEAD
+
+extern "C" void switch_context(uint32_t* save_esp, uint32_t load_esp);
+
+volatile uint32_t preempt_count = 0;
+volatile bool need_resched = false;
+
+static thread threads[MAX_THREADS];
+static thread* current = nullptr;
+static thread* idle_thread = nullptr;
+
+static thread* run_head[THREAD_PRIORITY_COUNT];
+static thread* run_tail[THREAD_PRIORITY_COUNT];
+// Sleepers sorted by wake_at, so each tick only looks at the head
+static thread* sleepers = nullptr;
+static thread* irq_waiters = nullptr;
+// Exited threads whose stacks the idle thread frees
+static thread* zombies = nullptr;
+
+static uint32_t slice_ticks = 1;
+static uint32_t context_switches = 0;
+
+static void enqueue(thread* t) {
+    t->next = nullptr;
+    if (run_tail[t->priority]) {
+        run_tail[t->priority]->next = t;
+    } else {
+        run_head[t->priority] = t;
+    }
+    run_tail[t->priority] = t;
+}
+
+static thread* dequeue() {
+    for (int priority = THREAD_PRIORITY_COUNT - 1; priority >= 0; priority--) {
+        thread* t = run_head[priority];
+        if (!t) continue;
+
+        run_head[priority] = t->next;
+        if (!t->next) run_tail[priority] = nullptr;
+        t->next = nullptr;
+        return t;
+    }
+    return nullptr;
+}
+
+static bool ready_at_or_above(int priority) {
+    for (int level = THREAD_PRIORITY_COUNT - 1; level >= priority; level--) {
+        if (run_head[level]) return true;
+    }
+    return false;
+}
+
+static void make_ready(thread* t) {
+    t->state = THREAD_READY;
+    enqueue(t);
+    if (t->priority > current->priority) {
+        need_resched = true;
+    }
+}
+
+// Interrupts must be off. The current thread goes back on its run queue
+// if it is still runnable; otherwise the caller has already parked it.
+static void schedule() {
+    thread* prev = current;
+    if (prev->state == THREAD_RUNNING) {
+        prev->state = THREAD_READY;
+        enqueue(prev);
+    }
+
+    // The idle thread is always runnable, so there is always a next
+    thread* next = dequeue();
+    need_resched = false;
+    next->state = THREAD_RUNNING;
+    next->slice = slice_ticks;
+    if (next == prev) return;
+
+    if (prev->stack && *(uint32_t*)prev->stack != STACK_CANARY) {
+        log_error(LOG_KERNEL, "Thread %s overflowed its stack\n", prev->name);
+        kernel_panic("Kernel stack overflow");
+    }
+
+    next->switches++;
+    context_switches++;
+    current = next;
+#if IRQ_STATS
+    // The next thread may resume through iret rather than irq_restore, so
+    // an interrupts-off section is only timed up to the switch
+    irq_off_end();
+#endif
+    switch_context(&prev->esp, next->esp);
+}
+
+// First code a new thread runs; it arrives from schedule() with
+// interrupts off
+static void thread_start() {
+    irq_restore(EFLAGS_IF);
+    current->entry(current->arg);
+    thread_exit();
+}
+
+static void idle_loop(void*) {
+    for (;;) {
+        uint32_t flags = irq_save();
+        thread* t = zombies;
+        if (t) zombies = t->next;
+        irq_restore(flags);
+
+        if (t) {
+            kfree(t->stack);
+            t->stack = nullptr;
+            t->state = THREAD_UNUSED;
+            continue;
+        }
+
+        asm volatile("hlt");
+    }
+}
+
+static thread* alloc_thread() {
+    for (int i = 0; i < MAX_THREADS; i++) {
+        if (threads[i].state == THREAD_UNUSED) return &threads[i];
+    }
+    return nullptr;
+}
+
+bool init_threads() {
+    for (int i = 0; i < MAX_THREADS; i++) {
+        threads[i].state = THREAD_UNUSED;
+    }
+    for (int i = 0; i < THREAD_PRIORITY_COUNT; i++) {
+        run_head[i] = nullptr;
+        run_tail[i] = nullptr;
+    }
+
+    uint32_t ticks = THREAD_SLICE_MS * timer_hz() / 1000;
+    slice_ticks = ticks ? ticks : 1;
+
+    // Whatever called us keeps running on the boot stack
+    thread* boot = &threads[0];
+    boot->name = "kernel";
+    boot->stack = nullptr;
+    boot->priority = THREAD_PRIORITY_HIGH;
+    boot->state = THREAD_RUNNING;
+    boot->slice = slice_ticks;
+    boot->switches = 0;
+    current = boot;
+
+    idle_thread = thread_create("idle", idle_loop, nullptr, THREAD_PRIORITY_IDLE);
+    if (!idle_thread) {
+        current = nullptr;
+        return false;
+    }
+    return true;
+}
+
+thread* thread_create(const char* name, thread_entry entry, void* arg, thread_priority priority) {
+    uint32_t flags = irq_save();
+    thread* t = alloc_thread();
+    if (t) t->state = THREAD_BLOCKED; // claimed
+    irq_restore(flags);
+
+    if (!t) {
+        log_error(LOG_KERNEL, "No free thread slot for %s\n", name);
+        return nullptr;
+    }
+
+    // Stacks this size come from the demand-zero buddy window. Every page is
+    // touched now: a fault on an unmapped stack page could not push its own
+    // frame and would end in a triple fault.
+    t->stack = (uint8_t*)kmalloc(THREAD_STACK_SIZE);
+    if (!t->stack) {
+        t->state = THREAD_UNUSED;
+        log_error(LOG_KERNEL, "No memory for the stack of %s\n", name);
+        return nullptr;
+    }
+    memset(t->stack, 0, THREAD_STACK_SIZE);
+    *(uint32_t*)t->stack = STACK_CANARY;
+
+    // Lay out the frame switch_context pops: edi, esi, ebx, ebp, then the
+    // return address
+    uint32_t* sp = (uint32_t*)(t->stack + THREAD_STACK_SIZE);
+    *--sp = (uint32_t)thread_start;
+    for (int i = 0; i < 4; i++) {
+        *--sp = 0;
+    }
+
+    t->esp = (uint32_t)sp;
+    t->name = name;
+    t->entry = entry;
+    t->arg = arg;
+    t->priority = priority;
+    t->switches = 0;
+
+    flags = irq_save();
+    make_ready(t);
+    irq_restore(flags);
+
+    log_debug(LOG_KERNEL, "Thread %s created at priority %d\n", name, priority);
+    return t;
+}
+
+thread* thread_current() {
+    return current;
+}
+
+void thread_yield() {
+    uint32_t flags = irq_save();
+    schedule();
+    irq_restore(flags);
+}
+
+void thread_exit() {
+    irq_save();
+    current->state = THREAD_ZOMBIE;
+    current->next = zombies;
+    zombies = current;
+    schedule();
+    // A zombie is never scheduled again
+    for (;;);
+}
+
+bool thread_can_sleep() {
+    return current && smp_cpu_id() == 0 && preempt_count == 0 && interrupts_enabled();
+}
+
+void thread_sleep_until(uint64_t deadline) {
+    uint32_t flags = irq_save();
+    if (ktime_ns() < deadline) {
+        current->state = THREAD_SLEEPING;
+        current->wake_at = deadline;
+
+        thread** link = &sleepers;
+        while (*link && (*link)->wake_at <= deadline) {
+            link = &(*link)->next;
+        }
+        current->next = *link;
+        *link = current;
+
+        schedule();
+    }
+    irq_restore(flags);
+}
+
+void thread_wait_interrupt() {
+    uint32_t flags = irq_save();
+    current->state = THREAD_BLOCKED;
+    current->next = irq_waiters;
+    irq_waiters = current;
+    schedule();
+    irq_restore(flags);
+}
+
+void thread_tick() {
+    if (!current) return;
+
+    uint64_t now = ktime_ns();
+    while (sleepers && sleepers->wake_at <= now) {
+        thread* t = sleepers;
+        sleepers = t->next;
+        make_ready(t);
+    }
+
+    if (current->slice && --current->slice == 0) {
+        if (ready_at_or_above(current->priority)) {
+            need_resched = true;
+        } else {
+            current->slice = slice_ticks;
+        }
+    }
+}
+
+void thread_irq_exit() {
+    if (!current) return;
+
+    while (irq_waiters) {
+        thread* t = irq_waiters;
+        irq_waiters = t->next;
+        make_ready(t);
+    }
+
+    // The preempted thread resumes here later and returns through iret
+    if (need_resched && preempt_count == 0) {
+        schedule();
+    }
+}
+
+// APs run jobs, not threads, so only the BSP ever switches
+void preempt_schedule() {
+    if (!current || smp_cpu_id() != 0 || !interrupts_enabled()) return;
+
+    uint32_t flags = irq_save();
+    schedule();
+    irq_restore(flags);
+}
+
+void thread_stats() {
+    static const char* const state_names[] = {
+        "unused", "ready", "running", "sleeping", "blocked", "zombie"
+    };
+
+    serial_printf("Threads - %u context switches, %u ticks per slice\n",
+                  context_switches, slice_ticks);
+    for (int i = 0; i < MAX_THREADS; i++) {
+        thread* t = &threads[i];
+        if (t->state == THREAD_UNUSED) continue;
+        serial_printf("  %s: priority %d, %s, scheduled %u times\n",
+                      t->name, t->priority, state_names[t->state], t->switches);
+    }
+}
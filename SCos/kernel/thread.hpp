@@ -0,0 +1,91 @@
+#ifndef THREAD_HPP
+#define THREAD_HPP
+
+#include <stdint.h>
+
+// Preemptive kernel threads. Each priority level has a round-robin run
+// queue and the highest non-empty level always runs; a thread gives up the
+// CPU when it blocks, when its time slice ends with a peer of the same
+// priority ready, or when a higher-priority thread wakes. Switches happen
+// at IRQ exit, on preempt_enable(), or when a thread blocks or yields.
+
+#define MAX_THREADS 16
+#define THREAD_STACK_SIZE (16 * 1024)
+#define THREAD_SLICE_MS 10
+
+enum thread_priority {
+    THREAD_PRIORITY_IDLE,
+    THREAD_PRIORITY_LOW,      // background app work
+    THREAD_PRIORITY_NORMAL,
+    THREAD_PRIORITY_HIGH,     // input and compositing
+    THREAD_PRIORITY_COUNT
+};
+
+enum thread_state {
+    THREAD_UNUSED,
+    THREAD_READY,
+    THREAD_RUNNING,
+    THREAD_SLEEPING,
+    THREAD_BLOCKED,
+    THREAD_ZOMBIE
+};
+
+typedef void (*thread_entry)(void* arg);
+
+struct thread {
+    uint32_t esp;
+    thread* next;
+    uint8_t* stack;
+    thread_entry entry;
+    void* arg;
+    const char* name;
+    uint8_t priority;
+    uint8_t state;
+    uint32_t slice;
+    uint64_t wake_at;
+    uint32_t switches;
+};
+
+// Adopts the calling context as the high-priority "kernel" thread and
+// starts the idle thread; needs the heap and the timer
+bool init_threads();
+// Returns nullptr when the thread table or the heap is exhausted. The
+// thread starts with interrupts on and exits when `entry` returns.
+thread* thread_create(const char* name, thread_entry entry, void* arg, thread_priority priority);
+thread* thread_current();
+void thread_yield();
+void thread_exit() __attribute__((noreturn));
+
+// Blocking is only allowed from thread context on the BSP with interrupts
+// on and preemption enabled; thread_can_sleep() says whether that holds
+bool thread_can_sleep();
+// Sleeps until ktime_ns() reaches the deadline, checked on every tick
+void thread_sleep_until(uint64_t deadline);
+// Sleeps until the next interrupt of any kind, like hlt does for the CPU
+void thread_wait_interrupt();
+
+// Called from the IRQ0 handler and at the end of every IRQ
+void thread_tick();
+void thread_irq_exit();
+void thread_stats();
+
+// Heap and other shared structures that are not interrupt-safe disable
+// preemption around their updates. The sections nest; a switch requested
+// meanwhile happens at the outermost preempt_enable(). The count is shared
+// by every CPU, so an AP holding a spinlock also holds off switches on the
+// BSP; a switch it defers waits for the BSP's next interrupt.
+extern volatile uint32_t preempt_count;
+extern volatile bool need_resched;
+void preempt_schedule();
+
+static inline void preempt_disable() {
+    __atomic_add_fetch(&preempt_count, 1, __ATOMIC_ACQUIRE);
+}
+
+static inline void preempt_enable() {
+    if (__atomic_sub_fetch(&preempt_count, 1, __ATOMIC_RELEASE) == 0 && need_resched) {
+        preempt_schedule();
+    }
+}
+
+#endif
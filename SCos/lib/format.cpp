@@ -0,0 +1,197 @@
+#include "../include/format.hpp"
+#include "../include/string.h"
+#include "../include/string.hpp"
+#include "../include/stdint.h"
+
+#define FORMAT_LEFT 0x01
+#define FORMAT_ZERO 0x02
+
+static const char pad_spaces[] = "                ";
+static const char pad_zeros[] = "0000000000000000";
+
+static void emit_padding(format_sink sink, void* context, char fill, int count) {
+    const char* run = fill == '0' ? pad_zeros : pad_spaces;
+    while (count > 0) {
+        int chunk = count < 16 ? count : 16;
+        sink(context, run, chunk);
+        count -= chunk;
+    }
+}
+
+// Writes `prefix` (a sign or "0x") and `body` into a field of `width`
+static int emit_field(format_sink sink, void* context, int flags, int width,
+                      const char* prefix, size_t prefix_length,
+                      const char* body, size_t body_length) {
+    int length = (int)(prefix_length + body_length);
+    int padding = width > length ? width - length : 0;
+
+    if (!(flags & (FORMAT_LEFT | FORMAT_ZERO))) emit_padding(sink, context, ' ', padding);
+    if (prefix_length) sink(context, prefix, prefix_length);
+    // Zero padding goes between the sign and the digits
+    if (flags & FORMAT_ZERO && !(flags & FORMAT_LEFT)) emit_padding(sink, context, '0', padding);
+    if (body_length) sink(context, body, body_length);
+    if (flags & FORMAT_LEFT) emit_padding(sink, context, ' ', padding);
+
+    return length + padding;
+}
+
+// Writes digits backwards ending at `end`; returns the first digit
+static char* format_unsigned(char* end, uint32_t value, uint32_t base, bool upper) {
+    const char* symbols = upper ? "0123456789ABCDEF" : "0123456789abcdef";
+    char* p = end;
+    do {
+        *--p = symbols[value % base];
+        value /= base;
+    } while (value);
+    return p;
+}
+
+int kvformat(format_sink sink, void* context, const char* format, va_list args) {
+    int total = 0;
+
+    while (*format) {
+        // Hand literal runs to the sink whole
+        const char* run = format;
+        while (*format && *format != '%') format++;
+        if (format != run) {
+            sink(context, run, format - run);
+            total += format - run;
+        }
+        if (!*format) break;
+        const char* spec = format++;
+
+        int flags = 0;
+        for (;; format++) {
+            if (*format == '-') flags |= FORMAT_LEFT;
+            else if (*format == '0') flags |= FORMAT_ZERO;
+            else break;
+        }
+
+        int width = 0;
+        if (*format == '*') {
+            width = va_arg(args, int);
+            if (width < 0) {
+                flags |= FORMAT_LEFT;
+                width = -width;
+            }
+            format++;
+        } else {
+            while (*format >= '0' && *format <= '9') {
+                width = width * 10 + (*format++ - '0');
+            }
+        }
+
+        int precision = -1;
+        if (*format == '.') {
+            format++;
+            precision = 0;
+            if (*format == '*') {
+                precision = va_arg(args, int);
+                format++;
+            } else {
+                while (*format >= '0' && *format <= '9') {
+                    precision = precision * 10 + (*format++ - '0');
+                }
+            }
+        }
+
+        while (*format == 'l' || *format == 'z') format++;
+
+        char digits[12];
+        char* end = digits + sizeof(digits);
+        char conversion = *format;
+        if (!conversion) break;
+        format++;
+
+        switch (conversion) {
+            case 'd':
+            case 'i': {
+                int value = va_arg(args, int);
+                uint32_t magnitude = value < 0 ? 0u - (uint32_t)value : (uint32_t)value;
+                char* first = format_unsigned(end, magnitude, 10, false);
+                total += emit_field(sink, context, flags, width, "-", value < 0, first, end - first);
+                break;
+            }
+            case 'u':
+            case 'x':
+            case 'X': {
+                uint32_t value = va_arg(args, uint32_t);
+                char* first = format_unsigned(end, value, conversion == 'u' ? 10 : 16, conversion == 'X');
+                total += emit_field(sink, context, flags, width, "", 0, first, end - first);
+                break;
+            }
+            case 'p': {
+                uint32_t value = (uint32_t)va_arg(args, void*);
+                char* first = format_unsigned(end, value, 16, false);
+                total += emit_field(sink, context, flags, width, "0x", 2, first, end - first);
+                break;
+            }
+            case 's': {
+                const char* str = va_arg(args, const char*);
+                if (!str) str = "(null)";
+                size_t length = 0;
+                // A precision bounds the read, so unterminated spans are fine
+                while ((precision < 0 || (int)length < precision) && str[length]) length++;
+                total += emit_field(sink, context, flags & FORMAT_LEFT, width, "", 0, str, length);
+                break;
+            }
+            case 'c': {
+                char c = (char)va_arg(args, int);
+                total += emit_field(sink, context, flags & FORMAT_LEFT, width, "", 0, &c, 1);
+                break;
+            }
+            case '%':
+                sink(context, "%", 1);
+                total++;
+                break;
+            default:
+                // Unknown conversions are echoed so the mistake is visible
+                sink(context, spec, format - spec);
+                total += format - spec;
+                break;
+        }
+    }
+
+    return total;
+}
+
+int kformat(format_sink sink, void* context, const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    int total = kvformat(sink, context, format, args);
+    va_end(args);
+    return total;
+}
+
+struct buffer_sink {
+    char* buffer;
+    size_t capacity;
+    size_t length;
+};
+
+// Keeps what fits and drops the rest; the caller terminates
+static void write_buffer(void* context, const char* data, size_t length) {
+    buffer_sink* out = (buffer_sink*)context;
+    size_t room = out->capacity - out->length;
+    size_t count = length < room ? length : room;
+    memcpy(out->buffer + out->length, data, count);
+    out->length += count;
+}
+
+extern "C" {
+int vsnprintf(char* buffer, size_t size, const char* format, va_list args) {
+    // One byte is held back for the terminator
+    buffer_sink out = {buffer, size ? size - 1 : 0, 0};
+    int total = kvformat(write_buffer, &out, format, args);
+    if (size) buffer[out.length] = '\0';
+    return total;
+}
+
+int snprintf(char* buffer, size_t size, const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    int total = vsnprintf(buffer, size, format, args);
+    va_end(args);
+    return total;
+}
+}
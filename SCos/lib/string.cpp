@@ -1,11 +1,41 @@
 
 #include "../include/string.hpp"
 
+// Word loads may alias any object; the typedef keeps that well-defined
+typedef uint32_t __attribute__((may_alias)) string_word;
+
+#define ONES_WORD 0x01010101u
+#define HIGHS_WORD 0x80808080u
+// Below this many bytes the rep string setup costs more than it saves
+#define REP_THRESHOLD 16
+
+// Nonzero if any byte of `word` is zero. Forced inline because the kernel
+// is built without optimization.
+static inline __attribute__((always_inline)) uint32_t has_zero_byte(uint32_t word) {
+    return (word - ONES_WORD) & ~word & HIGHS_WORD;
+}
+
 extern "C" {
 void* memset(void* ptr, int value, size_t size) {
     unsigned char* p = (unsigned char*)ptr;
+    unsigned char byte = (unsigned char)value;
+
+    if (size >= REP_THRESHOLD) {
+        // Byte stores up to a word boundary, then whole words
+        size_t head = -(uint32_t)p & 3;
+        size -= head;
+        size_t words = size / 4;
+        asm volatile("rep stosb\n\t"
+                     "mov %[words], %%ecx\n\t"
+                     "rep stosl"
+                     : "+D"(p), "+c"(head)
+                     : "a"(byte * ONES_WORD), [words] "r"(words)
+                     : "memory");
+        size &= 3;
+    }
+
     while (size--) {
-        *p++ = (unsigned char)value;
+        *p++ = byte;
     }
     return ptr;
 }
@@ -13,6 +43,21 @@ void* memset(void* ptr, int value, size_t size) {
 void* memcpy(void* dest, const void* src, size_t size) {
     unsigned char* d = (unsigned char*)dest;
     const unsigned char* s = (const unsigned char*)src;
+
+    if (size >= REP_THRESHOLD) {
+        // Align the destination; misaligned loads are cheaper than stores
+        size_t head = -(uint32_t)d & 3;
+        size -= head;
+        size_t words = size / 4;
+        asm volatile("rep movsb\n\t"
+                     "mov %[words], %%ecx\n\t"
+                     "rep movsl"
+                     : "+D"(d), "+S"(s), "+c"(head)
+                     : [words] "r"(words)
+                     : "memory");
+        size &= 3;
+    }
+
     while (size--) {
         *d++ = *s++;
     }
@@ -22,6 +67,15 @@ void* memcpy(void* dest, const void* src, size_t size) {
 int memcmp(const void* ptr1, const void* ptr2, size_t size) {
     const unsigned char* p1 = (const unsigned char*)ptr1;
     const unsigned char* p2 = (const unsigned char*)ptr2;
+
+    // Skip equal words; the first differing word is resolved bytewise so
+    // the sign of the result follows memory order
+    while (size >= 4 && *(const string_word*)p1 == *(const string_word*)p2) {
+        p1 += 4;
+        p2 += 4;
+        size -= 4;
+    }
+
     while (size--) {
         if (*p1 != *p2) {
             return *p1 - *p2;
@@ -33,11 +87,24 @@ int memcmp(const void* ptr1, const void* ptr2, size_t size) {
 }
 
 size_t strlen(const char* str) {
-    size_t len = 0;
-    while (str[len]) {
-        len++;
+    const char* p = str;
+
+    while ((uint32_t)p & 3) {
+        if (!*p) return p - str;
+        p++;
+    }
+
+    // Aligned word reads never cross into an unmapped page
+    const string_word* w = (const string_word*)p;
+    while (!has_zero_byte(*w)) {
+        w++;
+    }
+
+    p = (const char*)w;
+    while (*p) {
+        p++;
     }
-    return len;
+    return p - str;
 }
 
 char* strcpy(char* dest, const char* src) {
@@ -0,0 +1,102 @@
+#include "arena.hpp"
+#include "../debug/log.hpp"
+#include "../include/memory.h"
+
+static inline uint8_t* chunk_data(arena_chunk* chunk) {
+    return reinterpret_cast<uint8_t*>(chunk + 1);
+}
+
+// Bumps the offset inside one chunk, or returns nullptr if it does not fit
+static void* chunk_alloc(arena_chunk* chunk, size_t size, size_t align) {
+    uint32_t base = (uint32_t)chunk_data(chunk);
+    uint32_t start = (base + chunk->used + align - 1) & ~(align - 1);
+    if (start - base > chunk->size || chunk->size - (start - base) < size) {
+        return static_cast<void*>(nullptr);
+    }
+    chunk->used = start - base + size;
+    return (void*)start;
+}
+
+void arena_init(arena* a, size_t chunk_size) {
+    a->current = nullptr;
+    a->first = nullptr;
+    a->chunk_size = chunk_size > sizeof(arena_chunk) ? chunk_size : ARENA_DEFAULT_CHUNK;
+    a->chunk_count = 0;
+}
+
+void* arena_alloc(arena* a, size_t size, size_t align) {
+    if (align == 0 || (align & (align - 1))) {
+        log_error(LOG_MEMORY, "Arena alignment %d is not a power of two\n", align);
+        return static_cast<void*>(nullptr);
+    }
+
+    if (a->current) {
+        void* ptr = chunk_alloc(a->current, size, align);
+        if (ptr) return ptr;
+    }
+
+    // Oversized requests get a chunk of their own
+    size_t payload = a->chunk_size - sizeof(arena_chunk);
+    if (size + align > payload) payload = size + align;
+
+    arena_chunk* chunk = (arena_chunk*)kmalloc(sizeof(arena_chunk) + payload);
+    if (!chunk) {
+        log_error(LOG_MEMORY, "Arena chunk allocation of %d bytes failed\n", payload);
+        return static_cast<void*>(nullptr);
+    }
+
+    chunk->prev = a->current;
+    chunk->size = payload;
+    chunk->used = 0;
+    if (!a->first) a->first = chunk;
+    a->current = chunk;
+    a->chunk_count++;
+
+    return chunk_alloc(chunk, size, align);
+}
+
+char* arena_strndup(arena* a, const char* str, size_t length) {
+    char* copy = (char*)arena_alloc(a, length + 1, 1);
+    if (!copy) return nullptr;
+    memcpy(copy, str, length);
+    copy[length] = '\0';
+    return copy;
+}
+
+arena_mark arena_save(arena* a) {
+    arena_mark mark;
+    mark.chunk = a->current;
+    mark.used = a->current ? a->current->used : 0;
+    return mark;
+}
+
+// Frees every chunk newer than the mark. The first chunk is kept so that a
+// per-command or per-parse arena does not go back to the heap every time.
+void arena_reset(arena* a, arena_mark mark) {
+    while (a->current && a->current != mark.chunk && a->current != a->first) {
+        arena_chunk* prev = a->current->prev;
+        kfree(a->current);
+        a->current = prev;
+        a->chunk_count--;
+    }
+
+    if (!a->current) return;
+    a->current->used = a->current == mark.chunk ? mark.used : 0;
+}
+
+void arena_reset(arena* a) {
+    arena_mark start;
+    start.chunk = nullptr;
+    start.used = 0;
+    arena_reset(a, start);
+}
+
+void arena_release(arena* a) {
+    while (a->current) {
+        arena_chunk* prev = a->current->prev;
+        kfree(a->current);
+        a->current = prev;
+    }
+    a->first = nullptr;
+    a->chunk_count = 0;
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "../include/stddef.h"
+#include <stdint.h>
+
+// Bump-pointer arena for short-lived scratch memory. Allocations are never
+// freed individually; a whole parse or command is released at once by
+// resetting to a mark. Chunks come from kmalloc and are chained when the
+// current one runs out.
+#define ARENA_DEFAULT_CHUNK 4096
+#define ARENA_ALIGN 8
+
+struct arena_chunk {
+    arena_chunk* prev;
+    size_t size;
+    size_t used;
+};
+
+struct arena {
+    arena_chunk* current;
+    arena_chunk* first;
+    size_t chunk_size;
+    uint32_t chunk_count;
+};
+
+struct arena_mark {
+    arena_chunk* chunk;
+    size_t used;
+};
+
+void arena_init(arena* a, size_t chunk_size = ARENA_DEFAULT_CHUNK);
+void* arena_alloc(arena* a, size_t size, size_t align = ARENA_ALIGN);
+char* arena_strndup(arena* a, const char* str, size_t length);
+arena_mark arena_save(arena* a);
+void arena_reset(arena* a, arena_mark mark);
+void arena_reset(arena* a);
+void arena_release(arena* a);
+
+inline void* operator new(size_t, void* ptr) noexcept { return ptr; }
+inline void* operator new[](size_t, void* ptr) noexcept { return ptr; }
+
+template <typename T, typename... Args>
+T* arena_new(arena* a, Args... args) {
+    void* mem = arena_alloc(a, sizeof(T), alignof(T));
+    if (!mem) return nullptr;
+    return new (mem) T(args...);
+}
+
+// Rolls the arena back to where it was when the scope was entered.
+// Destructors of objects placed in the arena are not run.
+struct arena_scope {
+    arena* owner;
+    arena_mark mark;
+
+    explicit arena_scope(arena* a) : owner(a), mark(arena_save(a)) {}
+    ~arena_scope() { arena_reset(owner, mark); }
+    arena_scope(const arena_scope&) = delete;
+    arena_scope& operator=(const arena_scope&) = delete;
+};
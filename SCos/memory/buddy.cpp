@@ -0,0 +1,169 @@
+#include "buddy.hpp"
+#include "pmm.hpp"
+#include "paging.hpp"
+#include "../debug/serial.hpp"
+#include "../debug/log.hpp"
+#include "../include/memory.h"
+
+// Power-of-two buddy allocator over a demand-zero virtual window. Block
+// metadata is kept out of band, one entry per page, so free blocks never
+// have to be touched (and backed) just to link them into a free list.
+#define BUDDY_PAGE_COUNT (BUDDY_REGION_SIZE / PAGE_SIZE)
+#define BUDDY_NONE 0xFFFF
+#define BUDDY_FREE 0x01
+#define BUDDY_ALLOCATED 0x02
+
+struct buddy_page {
+    uint16_t next;
+    uint16_t prev;
+    uint8_t order;
+    uint8_t flags;
+};
+
+static buddy_page* pages = nullptr;
+static uint16_t free_heads[BUDDY_MAX_ORDER + 1];
+static uint32_t free_order_map = 0;
+static uint32_t allocations = 0;
+static uint32_t splits = 0;
+static uint32_t merges = 0;
+static uint32_t pages_in_use = 0;
+
+static void free_list_push(uint16_t index, uint8_t order) {
+    pages[index].order = order;
+    pages[index].flags = BUDDY_FREE;
+    pages[index].prev = BUDDY_NONE;
+    pages[index].next = free_heads[order];
+    if (free_heads[order] != BUDDY_NONE) pages[free_heads[order]].prev = index;
+    free_heads[order] = index;
+    free_order_map |= 1u << order;
+}
+
+static void free_list_remove(uint16_t index) {
+    uint8_t order = pages[index].order;
+    if (pages[index].prev != BUDDY_NONE) pages[pages[index].prev].next = pages[index].next;
+    else free_heads[order] = pages[index].next;
+    if (pages[index].next != BUDDY_NONE) pages[pages[index].next].prev = pages[index].prev;
+    if (free_heads[order] == BUDDY_NONE) free_order_map &= ~(1u << order);
+    pages[index].flags = 0;
+}
+
+bool init_buddy() {
+    pages = (buddy_page*)kmalloc(BUDDY_PAGE_COUNT * sizeof(buddy_page));
+    if (!pages) {
+        log_error(LOG_MEMORY, "No memory for page allocator metadata\n");
+        return false;
+    }
+
+    if (!paging_add_demand_region(BUDDY_VIRT_BASE, BUDDY_REGION_SIZE)) {
+        log_error(LOG_MEMORY, "Could not reserve page allocator window at 0x%x\n", BUDDY_VIRT_BASE);
+        return false;
+    }
+
+    for (int order = 0; order <= BUDDY_MAX_ORDER; order++) {
+        free_heads[order] = BUDDY_NONE;
+    }
+    free_order_map = 0;
+    for (uint32_t i = 0; i < BUDDY_PAGE_COUNT; i++) {
+        pages[i].flags = 0;
+    }
+    for (uint32_t i = 0; i < BUDDY_PAGE_COUNT; i += 1 << BUDDY_MAX_ORDER) {
+        free_list_push(i, BUDDY_MAX_ORDER);
+    }
+
+    log_info(LOG_MEMORY, "Page allocator: 0x%x - 0x%x, orders 0-%d\n",
+             BUDDY_VIRT_BASE, BUDDY_VIRT_BASE + BUDDY_REGION_SIZE, BUDDY_MAX_ORDER);
+    return true;
+}
+
+void* kmalloc_pages(size_t count) {
+    if (!pages || count == 0) return static_cast<void*>(nullptr);
+
+    uint8_t order = 0;
+    while ((1u << order) < count) {
+        order++;
+    }
+    if (order > BUDDY_MAX_ORDER) return static_cast<void*>(nullptr);
+
+    // Smallest non-empty order that can satisfy the request
+    uint32_t candidates = free_order_map & ~((1u << order) - 1);
+    if (!candidates) return static_cast<void*>(nullptr);
+    uint8_t found = __builtin_ctz(candidates);
+
+    uint16_t index = free_heads[found];
+    free_list_remove(index);
+
+    // Split down, handing the upper halves back to the free lists
+    while (found > order) {
+        found--;
+        free_list_push(index + (1 << found), found);
+        splits++;
+    }
+
+    pages[index].order = order;
+    pages[index].flags = BUDDY_ALLOCATED;
+    allocations++;
+    pages_in_use += 1 << order;
+    return (void*)(BUDDY_VIRT_BASE + index * PAGE_SIZE);
+}
+
+void kfree_pages(void* ptr) {
+    if (!ptr) return;
+
+    if (!buddy_owns(ptr) || ((uint32_t)ptr & (PAGE_SIZE - 1))) {
+        log_error(LOG_MEMORY, "Invalid page free 0x%x\n", (uint32_t)ptr);
+        return;
+    }
+
+    uint16_t index = ((uint32_t)ptr - BUDDY_VIRT_BASE) / PAGE_SIZE;
+    if (!(pages[index].flags & BUDDY_ALLOCATED)) {
+        log_error(LOG_MEMORY, "Page free of unallocated block 0x%x\n", (uint32_t)ptr);
+        return;
+    }
+
+    uint8_t order = pages[index].order;
+    pages[index].flags = 0;
+    pages_in_use -= 1 << order;
+
+    // Give the backing frames back; untouched pages were never mapped
+    for (uint32_t i = 0; i < (1u << order); i++) {
+        uint32_t frame = paging_unmap_page((uint32_t)ptr + i * PAGE_SIZE);
+        if (frame) pmm_free_frame(frame);
+    }
+
+    while (order < BUDDY_MAX_ORDER) {
+        uint16_t buddy = index ^ (1 << order);
+        if (!(pages[buddy].flags & BUDDY_FREE) || pages[buddy].order != order) break;
+
+        free_list_remove(buddy);
+        if (buddy < index) index = buddy;
+        order++;
+        merges++;
+    }
+
+    free_list_push(index, order);
+}
+
+bool buddy_owns(void* ptr) {
+    return pages && (uint32_t)ptr >= BUDDY_VIRT_BASE &&
+           (uint32_t)ptr < BUDDY_VIRT_BASE + BUDDY_REGION_SIZE;
+}
+
+size_t buddy_allocation_size(void* ptr) {
+    uint16_t index = ((uint32_t)ptr - BUDDY_VIRT_BASE) / PAGE_SIZE;
+    if (!(pages[index].flags & BUDDY_ALLOCATED)) return 0;
+    return (size_t)PAGE_SIZE << pages[index].order;
+}
+
+void buddy_stats() {
+    serial_printf("Page Allocator - %d pages in use, %d allocations, %d splits, %d merges\n",
+                  pages_in_use, allocations, splits, merges);
+    for (int order = 0; order <= BUDDY_MAX_ORDER; order++) {
+        uint32_t blocks = 0;
+        for (uint16_t i = free_heads[order]; i != BUDDY_NONE; i = pages[i].next) {
+            blocks++;
+        }
+        if (blocks) {
+            serial_printf("  order %d: %d free blocks\n", order, blocks);
+        }
+    }
+}
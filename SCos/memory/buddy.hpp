@@ -0,0 +1,17 @@
+#pragma once
+
+#include "../include/stddef.h"
+#include <stdint.h>
+
+// Virtual window the page allocator hands out; pages are backed on first
+// touch and returned to the frame allocator when freed.
+#define BUDDY_VIRT_BASE 0xE0000000
+#define BUDDY_MAX_ORDER 12
+#define BUDDY_REGION_SIZE (64 * 1024 * 1024)
+
+bool init_buddy();
+void* kmalloc_pages(size_t count);
+void kfree_pages(void* ptr);
+bool buddy_owns(void* ptr);
+size_t buddy_allocation_size(void* ptr);
+void buddy_stats();
@@ -1,133 +1,694 @@
 #include "heap.hpp"
 #include "../include/stddef.h"
 #include "../debug/serial.hpp"
+#include "../debug/log.hpp"
+#include "../debug/trace.hpp"
 #include "../include/memory.h"
+#include "pmm.hpp"
+#include "paging.hpp"
+#include "buddy.hpp"
+#include "heap_profile.hpp"
+#include "../kernel/spinlock.hpp"
 
 extern "C" {
-    extern uint32_t _kernel_end;
     void* memcpy(void* dest, const void* src, size_t size);
 }
 
+// The heap lives in its own virtual window and grows upwards in place.
+// Its pages are only backed (and zeroed) by the page-fault handler when
+// first touched, so neither reserving nor growing it touches memory.
+#define HEAP_INITIAL_SIZE (1 * 1024 * 1024)
+#define HEAP_MAX_SIZE (64 * 1024 * 1024)
+#define HEAP_GROW_STEP (64 * 1024)
+// Requests of at least this size go to the page allocator instead
+#define KMALLOC_PAGES_THRESHOLD PAGE_SIZE
+
 static uint32_t heap_start;
 static uint32_t heap_end;
-static uint32_t heap_current;
+static uint32_t heap_limit;
+static lock_stats heap_lock_stats = LOCK_STATS_INIT("heap");
+static spinlock heap_lock = SPINLOCK_INIT_STATS(&heap_lock_stats);
+
+// Every block carries its total size and a used bit in both a header word
+// and a footer word (boundary tags), so a free block can find and merge
+// with both physical neighbours in constant time. Free blocks additionally
+// keep next/prev links in their payload and sit in a size-binned free list.
+#define HEAP_USED 1u
+#define HEAP_TAG_SIZE sizeof(uint32_t)
+#define HEAP_ALIGN 8
+#define HEAP_BIN_COUNT 24
 
 struct heap_block {
-    uint32_t size;
-    bool used;
-    heap_block* next;
+    uint32_t tag;
+    heap_block* next_free;
+    heap_block* prev_free;
 };
 
+#define HEAP_MIN_BLOCK ((sizeof(heap_block) + HEAP_TAG_SIZE + HEAP_ALIGN - 1) & ~(HEAP_ALIGN - 1))
+
+static heap_block* free_bins[HEAP_BIN_COUNT];
+static uint32_t free_bin_map = 0;
 static heap_block* first_block = nullptr;
 
+// Size-class slab layer for small objects. Each slab is one page carved out
+// of the block list; objects of a class are handed out from per-page free
+// lists, so small kmalloc/kfree calls never walk the block list.
+#define HEAP_PAGE_SIZE PAGE_SIZE
+#define HEAP_PAGE_COUNT (HEAP_MAX_SIZE / HEAP_PAGE_SIZE)
+#define SLAB_MIN_SHIFT 4
+#define SLAB_CLASS_COUNT 6
+#define SLAB_MAX_SIZE (1 << (SLAB_MIN_SHIFT + SLAB_CLASS_COUNT - 1))
+
+struct slab_object {
+    slab_object* next;
+};
+
+struct slab_page {
+    slab_page* next;
+    slab_page* prev;
+    slab_object* free_list;
+    uint16_t in_use;
+    uint16_t capacity;
+    uint8_t class_index;
+};
+
+struct slab_class {
+    uint32_t object_size;
+    slab_page* partial;
+    uint32_t pages;
+    uint32_t hits;
+    uint32_t misses;
+    uint32_t frees;
+};
+
+static slab_class slab_classes[SLAB_CLASS_COUNT];
+// 0 = page belongs to the block list, otherwise slab class index + 1
+static uint8_t page_owner[HEAP_PAGE_COUNT];
+static bool slab_ready = false;
+
+static uint32_t realloc_in_place = 0;
+static uint32_t realloc_copied = 0;
+
+static void* block_alloc(size_t size);
+static void* block_alloc_aligned(size_t size, size_t align);
+static void block_free(void* ptr);
+static void heap_free(void* ptr);
+
+static inline uint32_t block_size(heap_block* block) {
+    return block->tag & ~HEAP_USED;
+}
+
+static inline bool block_used(heap_block* block) {
+    return block->tag & HEAP_USED;
+}
+
+static inline uint32_t* block_footer(heap_block* block) {
+    return (uint32_t*)((uint8_t*)block + block_size(block) - HEAP_TAG_SIZE);
+}
+
+static inline void block_set(heap_block* block, uint32_t size, bool used) {
+    block->tag = size | (used ? HEAP_USED : 0);
+    *block_footer(block) = block->tag;
+}
+
+static inline heap_block* block_next(heap_block* block) {
+    return (heap_block*)((uint8_t*)block + block_size(block));
+}
+
+static inline heap_block* block_prev(heap_block* block) {
+    uint32_t prev_tag = *(uint32_t*)((uint8_t*)block - HEAP_TAG_SIZE);
+    return (heap_block*)((uint8_t*)block - (prev_tag & ~HEAP_USED));
+}
+
+static inline void* block_payload(heap_block* block) {
+    return (uint8_t*)block + HEAP_TAG_SIZE;
+}
+
+static inline heap_block* payload_block(void* ptr) {
+    return (heap_block*)((uint8_t*)ptr - HEAP_TAG_SIZE);
+}
+
+static inline uint32_t block_request_size(size_t size) {
+    uint32_t total = (size + 2 * HEAP_TAG_SIZE + HEAP_ALIGN - 1) & ~(HEAP_ALIGN - 1);
+    return total < HEAP_MIN_BLOCK ? HEAP_MIN_BLOCK : total;
+}
+
+static int bin_index(uint32_t size) {
+    int index = 31 - __builtin_clz(size) - 4;
+    if (index < 0) return 0;
+    if (index >= HEAP_BIN_COUNT) return HEAP_BIN_COUNT - 1;
+    return index;
+}
+
+static void free_list_insert(heap_block* block) {
+    int index = bin_index(block_size(block));
+    block->prev_free = nullptr;
+    block->next_free = free_bins[index];
+    if (free_bins[index]) free_bins[index]->prev_free = block;
+    free_bins[index] = block;
+    free_bin_map |= 1u << index;
+}
+
+static void free_list_remove(heap_block* block) {
+    int index = bin_index(block_size(block));
+    if (block->prev_free) block->prev_free->next_free = block->next_free;
+    else free_bins[index] = block->next_free;
+    if (block->next_free) block->next_free->prev_free = block->prev_free;
+    if (!free_bins[index]) free_bin_map &= ~(1u << index);
+}
+
+// Marks the first `size` bytes of a free (already unlinked) block used and
+// returns the tail to the free lists when it is big enough to stand alone.
+static void block_place(heap_block* block, uint32_t size) {
+    uint32_t remaining = block_size(block) - size;
+    if (remaining >= HEAP_MIN_BLOCK) {
+        block_set(block, size, true);
+        heap_block* tail = block_next(block);
+        block_set(tail, remaining, false);
+        free_list_insert(tail);
+    } else {
+        block_set(block, block_size(block), true);
+    }
+}
+
 bool init_heap() {
-    heap_start = (_kernel_end + 0x1000) & ~0xFFF;
-    heap_end = heap_start + (1 * 1024 * 1024);
-    heap_current = heap_start;
+    heap_start = HEAP_VIRT_BASE;
+    heap_end = heap_start + HEAP_INITIAL_SIZE;
+    heap_limit = heap_start + HEAP_MAX_SIZE;
 
-    if (heap_start >= 0x1000000) {
-        serial_printf("ERROR: Heap start too high: 0x%x\n", heap_start);
+    if (!paging_add_demand_region(heap_start, HEAP_MAX_SIZE)) {
+        log_error(LOG_MEMORY, "Could not reserve heap window at 0x%x\n", heap_start);
         return false;
     }
 
-    uint8_t* clear_ptr = (uint8_t*)heap_start;
-    for (uint32_t i = 0; i < (heap_end - heap_start); i++) {
-        clear_ptr[i] = 0;
+    for (int i = 0; i < HEAP_BIN_COUNT; i++) {
+        free_bins[i] = nullptr;
+    }
+    free_bin_map = 0;
+
+    // A used prologue footer and a used zero-sized epilogue header fence the
+    // heap so coalescing never has to bounds-check its neighbours. The first
+    // block starts one tag past an aligned address so payloads are aligned.
+    *(uint32_t*)heap_start = HEAP_USED;
+    *(uint32_t*)(heap_end - HEAP_TAG_SIZE) = HEAP_USED;
+
+    first_block = (heap_block*)(heap_start + HEAP_ALIGN - HEAP_TAG_SIZE);
+    uint32_t first_size = (heap_end - HEAP_TAG_SIZE - (uint32_t)first_block) & ~(HEAP_ALIGN - 1);
+    block_set(first_block, first_size, false);
+    free_list_insert(first_block);
+
+    for (int i = 0; i < SLAB_CLASS_COUNT; i++) {
+        slab_classes[i].object_size = 1 << (SLAB_MIN_SHIFT + i);
+        slab_classes[i].partial = nullptr;
+        slab_classes[i].pages = 0;
+        slab_classes[i].hits = 0;
+        slab_classes[i].misses = 0;
+        slab_classes[i].frees = 0;
+    }
+    for (int i = 0; i < HEAP_PAGE_COUNT; i++) {
+        page_owner[i] = 0;
+    }
+    slab_ready = true;
+    realloc_in_place = 0;
+    realloc_copied = 0;
+
+    if (!init_heap_profile()) {
+        return false;
     }
 
-    first_block = (heap_block*)heap_start;
-    first_block->size = heap_end - heap_start - sizeof(heap_block);
-    first_block->used = false;
-    first_block->next = nullptr;
+    log_info(LOG_MEMORY, "Heap initialized: 0x%x - 0x%x (%d KB), can grow to 0x%x\n",
+             heap_start, heap_end, (heap_end - heap_start) / 1024, heap_limit);
+
+    return true;
+}
+
+// Extends the heap in place by at least `size` bytes. The old epilogue
+// becomes the header of the new block, which then merges with a free
+// block at the old end of the heap through the normal free path.
+static bool heap_grow(uint32_t size) {
+    uint32_t bytes = (size + HEAP_TAG_SIZE + PAGE_SIZE - 1) & ~(PAGE_SIZE - 1);
+    if (bytes < HEAP_GROW_STEP) bytes = HEAP_GROW_STEP;
+    if (heap_end + bytes > heap_limit) bytes = heap_limit - heap_end;
+    if (bytes < size + HEAP_TAG_SIZE) return false;
 
-    serial_printf("Heap initialized: 0x%x - 0x%x (%d KB)\n", 
-                  heap_start, heap_end, (heap_end - heap_start) / 1024);
-    serial_printf("Kernel end: 0x%x, Heap buffer: %d bytes\n", 
-                  _kernel_end, heap_start - _kernel_end);
+    if (pmm_free_frames() < bytes / PAGE_SIZE) {
+        log_warn(LOG_MEMORY, "Heap cannot grow past 0x%x, out of physical memory\n", heap_end);
+        return false;
+    }
 
+    heap_block* block = (heap_block*)(heap_end - HEAP_TAG_SIZE);
+    heap_end += bytes;
+    *(uint32_t*)(heap_end - HEAP_TAG_SIZE) = HEAP_USED;
+    block_set(block, bytes, true);
+    block_free(block_payload(block));
     return true;
 }
 
-void* kmalloc(size_t size) {
+static int slab_class_for(size_t size) {
+    int index = 0;
+    while ((1u << (SLAB_MIN_SHIFT + index)) < size) {
+        index++;
+    }
+    return index;
+}
+
+static uint32_t page_index(void* ptr) {
+    return ((uintptr_t)ptr - heap_start) / HEAP_PAGE_SIZE;
+}
+
+static slab_page* slab_grow(int class_index) {
+    slab_class* cls = &slab_classes[class_index];
+    slab_page* page = (slab_page*)block_alloc_aligned(HEAP_PAGE_SIZE, HEAP_PAGE_SIZE);
+    if (!page) return static_cast<slab_page*>(nullptr);
+
+    // Objects start at the first multiple of the object size past the
+    // header, so every object is naturally aligned to its class size.
+    uint32_t first = (sizeof(slab_page) + cls->object_size - 1) & ~(cls->object_size - 1);
+
+    page->next = cls->partial;
+    page->prev = nullptr;
+    page->free_list = nullptr;
+    page->in_use = 0;
+    page->capacity = (HEAP_PAGE_SIZE - first) / cls->object_size;
+    page->class_index = class_index;
+
+    for (int i = page->capacity - 1; i >= 0; i--) {
+        slab_object* obj = (slab_object*)((uint8_t*)page + first + i * cls->object_size);
+        obj->next = page->free_list;
+        page->free_list = obj;
+    }
+
+    if (cls->partial) cls->partial->prev = page;
+    cls->partial = page;
+    cls->pages++;
+    page_owner[page_index(page)] = class_index + 1;
+    return page;
+}
+
+static void* slab_alloc(size_t size) {
+    int class_index = slab_class_for(size);
+    slab_class* cls = &slab_classes[class_index];
+
+    slab_page* page = cls->partial;
+    if (page) {
+        cls->hits++;
+    } else {
+        cls->misses++;
+        page = slab_grow(class_index);
+        if (!page) return static_cast<void*>(nullptr);
+    }
+
+    slab_object* obj = page->free_list;
+    page->free_list = obj->next;
+    page->in_use++;
+
+    if (!page->free_list) {
+        // Page is full, drop it from the partial list
+        cls->partial = page->next;
+        if (cls->partial) cls->partial->prev = nullptr;
+        page->next = nullptr;
+    }
+
+    return obj;
+}
+
+static void slab_free(void* ptr, int class_index) {
+    slab_class* cls = &slab_classes[class_index];
+    slab_page* page = (slab_page*)((uintptr_t)ptr & ~(HEAP_PAGE_SIZE - 1));
+    bool was_full = page->free_list == nullptr;
+
+    slab_object* obj = (slab_object*)ptr;
+    obj->next = page->free_list;
+    page->free_list = obj;
+    page->in_use--;
+    cls->frees++;
+
+    if (was_full) {
+        page->prev = nullptr;
+        page->next = cls->partial;
+        if (cls->partial) cls->partial->prev = page;
+        cls->partial = page;
+    }
+
+    // Keep one empty page per class around, give the rest back to the block list
+    if (page->in_use == 0 && (page->prev || page->next)) {
+        if (page->prev) page->prev->next = page->next;
+        else cls->partial = page->next;
+        if (page->next) page->next->prev = page->prev;
+
+        cls->pages--;
+        page_owner[page_index(page)] = 0;
+        block_free(page);
+    }
+}
+
+static void* heap_alloc(size_t size) {
+    if (size == 0) return static_cast<void*>(nullptr);
+
+    if (slab_ready && size <= SLAB_MAX_SIZE) {
+        void* ptr = slab_alloc(size);
+        if (ptr) return ptr;
+    }
+
+    if (size < KMALLOC_PAGES_THRESHOLD) {
+        return block_alloc(size);
+    }
+
+    // Large requests fall back to the block list until the page allocator
+    // is up (its own metadata is allocated that way) or when it is full
+    void* ptr = kmalloc_pages((size + PAGE_SIZE - 1) / PAGE_SIZE);
+    if (!ptr) ptr = block_alloc(size);
+    if (!ptr) {
+        log_warn(LOG_MEMORY, "Large allocation of %d bytes failed\n", size);
+    }
+    return ptr;
+}
+
+// Returns memory whose address is a multiple of `align` (a power of two).
+// Each tier is already naturally aligned for some alignments: slab objects
+// to their class size and page allocations to their block size. Anything
+// else is carved at the right offset straight out of a free block.
+static void* heap_alloc_aligned(size_t size, size_t align) {
     if (size == 0) return static_cast<void*>(nullptr);
-    
-    if (size > (512 * 1024)) {
-        serial_printf("WARNING: Large allocation requested: %d bytes\n", size);
+
+    if (align & (align - 1)) {
+        log_error(LOG_MEMORY, "kmalloc_aligned alignment %d is not a power of two\n", align);
         return static_cast<void*>(nullptr);
     }
 
-    size = (size + 3) & ~3;
+    if (align <= HEAP_ALIGN) {
+        return heap_alloc(size);
+    }
 
-    heap_block* current = first_block;
-    while (current) {
-        if (!current->used && current->size >= size) {
-            if (current->size > size + sizeof(heap_block) + 4) {
-                heap_block* new_block = (heap_block*)((uint8_t*)current + sizeof(heap_block) + size);
-                new_block->size = current->size - size - sizeof(heap_block);
-                new_block->used = false;
-                new_block->next = current->next;
-
-                current->size = size;
-                current->next = new_block;
+    if (slab_ready && size <= SLAB_MAX_SIZE && align <= SLAB_MAX_SIZE) {
+        void* ptr = slab_alloc(size > align ? size : align);
+        if (ptr) return ptr;
+    }
+
+    if (align >= PAGE_SIZE || size >= KMALLOC_PAGES_THRESHOLD) {
+        size_t count = (size + PAGE_SIZE - 1) / PAGE_SIZE;
+        if (count < align / PAGE_SIZE) count = align / PAGE_SIZE;
+        void* ptr = kmalloc_pages(count);
+        if (ptr) return ptr;
+    }
+
+    return block_alloc_aligned(size, align);
+}
+
+// Usable size of a live allocation, or 0 if `ptr` is not one
+static uint32_t allocation_size(void* ptr) {
+    if (buddy_owns(ptr)) {
+        return buddy_allocation_size(ptr);
+    }
+    if ((uint32_t)ptr < heap_start || (uint32_t)ptr >= heap_end) {
+        return 0;
+    }
+    uint8_t owner = page_owner[page_index(ptr)];
+    if (owner) {
+        return slab_classes[owner - 1].object_size;
+    }
+    heap_block* block = payload_block(ptr);
+    if (!block_used(block)) return 0;
+    return block_size(block) - 2 * HEAP_TAG_SIZE;
+}
+
+// Every public entry point records its own caller, so the profiler
+// attributes memory to the code that asked for it rather than to wrappers.
+// Each also holds heap_lock, which keeps other CPUs out of the free lists
+// and, since it disables preemption, other threads too.
+void* kmalloc(size_t size) {
+    return kmalloc_caller(size, __builtin_return_address(0));
+}
+
+void* kmalloc_caller(size_t size, void* caller) {
+    TRACE(TRACE_KMALLOC, size);
+    spin_lock(&heap_lock);
+    void* ptr = heap_alloc(size);
+    if (ptr) heap_profile_alloc(ptr, size, allocation_size(ptr), caller);
+    spin_unlock(&heap_lock);
+    return ptr;
+}
+
+void* kmalloc_aligned(size_t size, size_t align) {
+    spin_lock(&heap_lock);
+    void* ptr = heap_alloc_aligned(size, align);
+    if (ptr) heap_profile_alloc(ptr, size, allocation_size(ptr), __builtin_return_address(0));
+    spin_unlock(&heap_lock);
+    return ptr;
+}
+
+void* kcalloc(size_t count, size_t size) {
+    if (count == 0 || size == 0) return static_cast<void*>(nullptr);
+    if (count > (size_t)-1 / size) {
+        log_error(LOG_MEMORY, "kcalloc overflow (%d x %d)\n", count, size);
+        return static_cast<void*>(nullptr);
+    }
+
+    spin_lock(&heap_lock);
+    void* ptr = heap_alloc(count * size);
+    if (ptr) {
+        heap_profile_alloc(ptr, count * size, allocation_size(ptr), __builtin_return_address(0));
+    }
+    spin_unlock(&heap_lock);
+
+    if (ptr) memset(ptr, 0, count * size);
+    return ptr;
+}
+
+// Unlinks and returns a free block of at least `needed` bytes. The
+// request's own bin may hold smaller blocks, so it is searched first-fit;
+// any block in a higher bin is large enough by construction.
+static heap_block* block_find(uint32_t needed) {
+    int index = bin_index(needed);
+
+    for (heap_block* block = free_bins[index]; block; block = block->next_free) {
+        if (block_size(block) >= needed) {
+            free_list_remove(block);
+            return block;
+        }
+    }
+
+    uint32_t higher = free_bin_map & ~((2u << index) - 1);
+    if (higher) {
+        heap_block* block = free_bins[__builtin_ctz(higher)];
+        free_list_remove(block);
+        return block;
+    }
+
+    return static_cast<heap_block*>(nullptr);
+}
+
+static void* block_alloc(size_t size) {
+    uint32_t needed = block_request_size(size);
+    heap_block* block = block_find(needed);
+    if (!block && heap_grow(needed)) {
+        block = block_find(needed);
+    }
+    if (!block) return static_cast<void*>(nullptr);
+
+    block_place(block, needed);
+    return block_payload(block);
+}
+
+// Carves a block whose payload starts on an `align` boundary straight out
+// of a free block, returning the leading gap to the free lists instead of
+// over-allocating by a whole alignment unit.
+static void* block_find_aligned(uint32_t needed, size_t align) {
+    for (int index = bin_index(needed); index < HEAP_BIN_COUNT; index++) {
+        for (heap_block* block = free_bins[index]; block; block = block->next_free) {
+            uintptr_t start = (uintptr_t)block;
+            uintptr_t end = start + block_size(block);
+            uintptr_t payload = (start + HEAP_TAG_SIZE + align - 1) & ~(align - 1);
+
+            if (payload - HEAP_TAG_SIZE != start && payload - HEAP_TAG_SIZE - start < HEAP_MIN_BLOCK) {
+                // Leave room for a free block in front of the aligned one
+                payload = (start + HEAP_TAG_SIZE + HEAP_MIN_BLOCK + align - 1) & ~(align - 1);
             }
+            if (payload - HEAP_TAG_SIZE + needed > end) continue;
+
+            free_list_remove(block);
 
-            current->used = true;
-            return (uint8_t*)current + sizeof(heap_block);
+            heap_block* aligned = (heap_block*)(payload - HEAP_TAG_SIZE);
+            if (aligned != block) {
+                uint32_t lead = (uintptr_t)aligned - start;
+                block_set(block, lead, false);
+                free_list_insert(block);
+                block_set(aligned, end - (uintptr_t)aligned, false);
+            }
+
+            block_place(aligned, needed);
+            return (void*)payload;
         }
-        current = current->next;
     }
 
     return static_cast<void*>(nullptr);
 }
 
+static void* block_alloc_aligned(size_t size, size_t align) {
+    uint32_t needed = block_request_size(size);
+    void* ptr = block_find_aligned(needed, align);
+    if (!ptr && heap_grow(needed + align + HEAP_MIN_BLOCK)) {
+        ptr = block_find_aligned(needed, align);
+    }
+    return ptr;
+}
+
 void kfree(void* ptr) {
     if (!ptr) return;
 
+    spin_lock(&heap_lock);
+    uint32_t size = allocation_size(ptr);
+    TRACE(TRACE_KFREE, size);
+    if (size) heap_profile_free(ptr, size);
+    heap_free(ptr);
+    spin_unlock(&heap_lock);
+}
+
+static void heap_free(void* ptr) {
+    if (buddy_owns(ptr)) {
+        kfree_pages(ptr);
+        return;
+    }
+
     if ((uint32_t)ptr < heap_start || (uint32_t)ptr >= heap_end) {
-        serial_printf("ERROR: Invalid free - ptr 0x%x outside heap 0x%x-0x%x\n", 
-                     (uint32_t)ptr, heap_start, heap_end);
+        log_error(LOG_MEMORY, "Invalid free - ptr 0x%x outside heap 0x%x-0x%x\n",
+                  (uint32_t)ptr, heap_start, heap_end);
+        return;
+    }
+
+    uint8_t owner = page_owner[page_index(ptr)];
+    if (owner) {
+        slab_free(ptr, owner - 1);
         return;
     }
 
-    heap_block* block = (heap_block*)((uint8_t*)ptr - sizeof(heap_block));
-    
+    block_free(ptr);
+}
+
+static void block_free(void* ptr) {
+    heap_block* block = payload_block(ptr);
+
     if ((uint32_t)block < heap_start || (uint32_t)block >= heap_end) {
-        serial_printf("ERROR: Invalid block header at 0x%x\n", (uint32_t)block);
+        log_error(LOG_MEMORY, "Invalid block header at 0x%x\n", (uint32_t)block);
         return;
     }
-    
-    block->used = false;
 
-    heap_block* current = first_block;
-    while (current) {
-        if (!current->used && current->next && !current->next->used) {
-            current->size += current->next->size + sizeof(heap_block);
-            current->next = current->next->next;
+    if (!block_used(block)) {
+        log_error(LOG_MEMORY, "Double free of 0x%x\n", (uint32_t)ptr);
+        return;
+    }
+
+    uint32_t size = block_size(block);
+
+    heap_block* next = block_next(block);
+    if (!block_used(next)) {
+        free_list_remove(next);
+        size += block_size(next);
+    }
+
+    uint32_t prev_tag = *(uint32_t*)((uint8_t*)block - HEAP_TAG_SIZE);
+    if (!(prev_tag & HEAP_USED)) {
+        heap_block* prev = block_prev(block);
+        free_list_remove(prev);
+        size += block_size(prev);
+        block = prev;
+    }
+
+    block_set(block, size, false);
+    free_list_insert(block);
+}
+
+// Resizes a block-list allocation without moving it: shrinking splits off
+// the tail, growing absorbs a free successor block (extending the heap
+// first when the block is the last one).
+static bool block_resize_in_place(heap_block* block, size_t size) {
+    uint32_t needed = block_request_size(size);
+    uint32_t current = block_size(block);
+
+    if (needed <= current) {
+        if (current - needed >= HEAP_MIN_BLOCK) {
+            block_set(block, needed, true);
+            heap_block* tail = block_next(block);
+            block_set(tail, current - needed, true);
+            block_free(block_payload(tail));
         }
-        current = current->next;
+        return true;
+    }
+
+    heap_block* next = block_next(block);
+    if (block_size(next) == 0 && heap_grow(needed - current)) {
+        next = block_next(block);
+    }
+    if (block_used(next) || current + block_size(next) < needed) {
+        return false;
     }
+
+    free_list_remove(next);
+    block_set(block, current + block_size(next), false);
+    block_place(block, needed);
+    return true;
 }
 
 void* krealloc(void* ptr, size_t size) {
-    if (!ptr) return kmalloc(size);
+    void* caller = __builtin_return_address(0);
+    if (!ptr) return kmalloc_caller(size, caller);
     if (size == 0) {
         kfree(ptr);
         return static_cast<void*>(nullptr);
     }
 
-    heap_block* block = (heap_block*)((uint8_t*)ptr - sizeof(heap_block));
-    if (block->size >= size) {
+    spin_lock(&heap_lock);
+    uint32_t old_size = allocation_size(ptr);
+    if (!old_size) {
+        spin_unlock(&heap_lock);
+        log_error(LOG_MEMORY, "krealloc of invalid pointer 0x%x\n", (uint32_t)ptr);
+        return static_cast<void*>(nullptr);
+    }
+
+    bool block_list = !buddy_owns(ptr) && !page_owner[page_index(ptr)];
+    if ((block_list && block_resize_in_place(payload_block(ptr), size)) || old_size >= size) {
+        heap_profile_free(ptr, old_size);
+        heap_profile_alloc(ptr, size, allocation_size(ptr), caller);
+        realloc_in_place++;
+        spin_unlock(&heap_lock);
         return ptr;
     }
+    realloc_copied++;
+    spin_unlock(&heap_lock);
 
-    void* new_ptr = kmalloc(size);
+    // The caller still owns ptr, so the copy needs no lock
+    void* new_ptr = kmalloc_caller(size, caller);
     if (new_ptr) {
-        memcpy(new_ptr, ptr, block->size < size ? block->size : size);
+        memcpy(new_ptr, ptr, old_size);
         kfree(ptr);
     }
     return new_ptr;
 }
 
+void heap_lock_acquire() {
+    spin_lock(&heap_lock);
+}
+
+void heap_lock_release() {
+    spin_unlock(&heap_lock);
+}
+
+// Free block-list bytes and the largest single free block. Free pages in
+// the page allocator are not counted; they do not fragment the heap.
+void heap_free_space(uint32_t* total, uint32_t* largest) {
+    *total = 0;
+    *largest = 0;
+    spin_lock(&heap_lock);
+    for (int i = 0; i < HEAP_BIN_COUNT; i++) {
+        for (heap_block* block = free_bins[i]; block; block = block->next_free) {
+            uint32_t size = block_size(block);
+            *total += size;
+            if (size > *largest) *largest = size;
+        }
+    }
+    spin_unlock(&heap_lock);
+}
+
 void heap_stats() {
     uint32_t total_blocks = 0;
     uint32_t used_blocks = 0;
@@ -135,21 +696,41 @@ void heap_stats() {
     uint32_t used_memory = 0;
     uint32_t free_memory = 0;
 
+    // Walk and snapshot under the lock; print after releasing it
+    spin_lock(&heap_lock);
     heap_block* current = first_block;
-    while (current) {
+    while (block_size(current)) {
         total_blocks++;
-        if (current->used) {
+        if (block_used(current)) {
             used_blocks++;
-            used_memory += current->size;
+            used_memory += block_size(current);
         } else {
             free_blocks++;
-            free_memory += current->size;
+            free_memory += block_size(current);
         }
-        current = current->next;
+        current = block_next(current);
+    }
+    uint32_t in_place = realloc_in_place;
+    uint32_t copied = realloc_copied;
+    slab_class slabs[SLAB_CLASS_COUNT];
+    for (int i = 0; i < SLAB_CLASS_COUNT; i++) {
+        slabs[i] = slab_classes[i];
     }
+    spin_unlock(&heap_lock);
 
-    serial_printf("Heap Stats - Blocks: %d total, %d used, %d free\n", 
+    serial_printf("Heap Stats - Blocks: %d total, %d used, %d free\n",
                   total_blocks, used_blocks, free_blocks);
-    serial_printf("Memory: %d KB used, %d KB free\n", 
+    serial_printf("Memory: %d KB used, %d KB free\n",
                   used_memory / 1024, free_memory / 1024);
+    serial_printf("Realloc: %d in place, %d copied\n", in_place, copied);
+
+    for (int i = 0; i < SLAB_CLASS_COUNT; i++) {
+        slab_class* cls = &slabs[i];
+        serial_printf("Slab %d: %d pages, %d hits, %d misses, %d frees\n",
+                      cls->object_size, cls->pages, cls->hits, cls->misses, cls->frees);
+    }
+
+    buddy_stats();
+    pmm_stats();
+    paging_stats();
 }
@@ -2,7 +2,16 @@
 
 #include "../include/stddef.h"
 #include "../include/memory.h"
+#include <stdint.h>
 
 bool init_heap();
+void* kmalloc_caller(size_t size, void* caller);
+void* kmalloc_aligned(size_t size, size_t align);
+void* kcalloc(size_t count, size_t size);
 void* krealloc(void* ptr, size_t size);
+void heap_free_space(uint32_t* total, uint32_t* largest);
+// Holds heap_lock for readers of state the allocator updates under it,
+// such as the profiler's tables; nothing may allocate while it is held
+void heap_lock_acquire();
+void heap_lock_release();
 void heap_stats();
\ No newline at end of file
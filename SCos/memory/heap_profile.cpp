@@ -0,0 +1,216 @@
+#include "heap_profile.hpp"
+#include "heap.hpp"
+#include "../debug/serial.hpp"
+#include "../debug/log.hpp"
+
+// Open-addressed side table from live pointer to call site. It lives on the
+// heap itself and is sized once, so recording an allocation never allocates.
+#define SLOT_MASK (HEAP_PROFILE_SLOTS - 1)
+#define SITE_MASK (HEAP_PROFILE_SITES - 1)
+#define SITE_OTHER HEAP_PROFILE_SITES
+#define SLOT_LOAD_LIMIT (HEAP_PROFILE_SLOTS * 3 / 4)
+
+struct profile_slot {
+    uint32_t ptr;
+    uint16_t site;
+    uint16_t reserved;
+};
+
+static profile_slot* slots = nullptr;
+static uint32_t slots_used = 0;
+// Last entry collects callers that did not fit in the site table
+static heap_profile_site sites[HEAP_PROFILE_SITES + 1];
+static uint32_t histogram[HEAP_PROFILE_BUCKETS];
+static heap_profile_summary totals;
+
+static inline uint32_t slot_home(uint32_t ptr) {
+    return ((ptr >> 3) * 2654435761u) >> (32 - __builtin_ctz(HEAP_PROFILE_SLOTS));
+}
+
+static inline uint32_t site_home(uint32_t caller) {
+    return (caller * 2654435761u) >> (32 - __builtin_ctz(HEAP_PROFILE_SITES));
+}
+
+static uint16_t site_lookup(uint32_t caller) {
+    uint32_t index = site_home(caller);
+    for (int probe = 0; probe < HEAP_PROFILE_SITES; probe++) {
+        heap_profile_site* site = &sites[index];
+        if (site->caller == caller) return index;
+        if (site->caller == 0) {
+            site->caller = caller;
+            return index;
+        }
+        index = (index + 1) & SITE_MASK;
+    }
+    return SITE_OTHER;
+}
+
+bool init_heap_profile() {
+    slots = nullptr;
+    slots_used = 0;
+    for (int i = 0; i <= HEAP_PROFILE_SITES; i++) {
+        sites[i].caller = 0;
+        sites[i].live_bytes = 0;
+        sites[i].live_count = 0;
+        sites[i].total_count = 0;
+    }
+    for (int i = 0; i < HEAP_PROFILE_BUCKETS; i++) {
+        histogram[i] = 0;
+    }
+    totals.live_bytes = 0;
+    totals.peak_bytes = 0;
+    totals.live_count = 0;
+    totals.total_count = 0;
+    totals.untracked = 0;
+
+    // Allocated before `slots` is set, so the table does not profile itself
+    profile_slot* table = (profile_slot*)kcalloc(HEAP_PROFILE_SLOTS, sizeof(profile_slot));
+    if (!table) {
+        log_error(LOG_MEMORY, "Could not allocate heap profiler table\n");
+        return false;
+    }
+    slots = table;
+    return true;
+}
+
+void heap_profile_alloc(void* ptr, size_t request, uint32_t size, void* caller) {
+    if (!slots || !ptr) return;
+
+    totals.live_bytes += size;
+    totals.live_count++;
+    totals.total_count++;
+    if (totals.live_bytes > totals.peak_bytes) {
+        totals.peak_bytes = totals.live_bytes;
+    }
+    histogram[31 - __builtin_clz(request)]++;
+
+    if (slots_used >= SLOT_LOAD_LIMIT) {
+        totals.untracked++;
+        return;
+    }
+
+    uint16_t site_index = site_lookup((uint32_t)caller);
+    heap_profile_site* site = &sites[site_index];
+    site->live_bytes += size;
+    site->live_count++;
+    site->total_count++;
+
+    uint32_t index = slot_home((uint32_t)ptr);
+    while (slots[index].ptr) {
+        index = (index + 1) & SLOT_MASK;
+    }
+    slots[index].ptr = (uint32_t)ptr;
+    slots[index].site = site_index;
+    slots_used++;
+}
+
+void heap_profile_free(void* ptr, uint32_t size) {
+    if (!slots || !ptr) return;
+
+    totals.live_bytes -= size;
+    totals.live_count--;
+
+    uint32_t index = slot_home((uint32_t)ptr);
+    while (slots[index].ptr != (uint32_t)ptr) {
+        if (!slots[index].ptr) {
+            // Allocated while the table was full
+            if (totals.untracked) totals.untracked--;
+            return;
+        }
+        index = (index + 1) & SLOT_MASK;
+    }
+
+    heap_profile_site* site = &sites[slots[index].site];
+    site->live_bytes -= size;
+    site->live_count--;
+
+    // Backward-shift deletion keeps probe chains intact without tombstones
+    uint32_t hole = index;
+    for (;;) {
+        index = (index + 1) & SLOT_MASK;
+        if (!slots[index].ptr) break;
+
+        uint32_t home = slot_home(slots[index].ptr);
+        bool movable = hole <= index ? (home <= hole || home > index)
+                                     : (home <= hole && home > index);
+        if (movable) {
+            slots[hole] = slots[index];
+            hole = index;
+        }
+    }
+    slots[hole].ptr = 0;
+    slots_used--;
+}
+
+// part * 100 / whole without overflowing 32 bits for large heaps
+static uint32_t percent_of(uint32_t part, uint32_t whole) {
+    if (!whole) return 100;
+    if (part < 0x01000000) return part * 100 / whole;
+    return part / (whole / 100);
+}
+
+// The readers below copy the tables under heap_lock, which the heap holds
+// while it calls heap_profile_alloc and heap_profile_free, and format from
+// the copy after releasing it.
+void heap_profile_get_summary(heap_profile_summary* summary) {
+    heap_lock_acquire();
+    *summary = totals;
+    heap_lock_release();
+    // Takes heap_lock itself
+    heap_free_space(&summary->free_bytes, &summary->largest_free);
+}
+
+// Fills `out` with up to `max` call sites ordered by live bytes
+int heap_profile_top_sites(heap_profile_site* out, int max) {
+    int count = 0;
+    heap_lock_acquire();
+    for (int i = 0; i <= HEAP_PROFILE_SITES; i++) {
+        if (!sites[i].live_count) continue;
+
+        int pos = count < max ? count++ : max;
+        while (pos > 0 && out[pos - 1].live_bytes < sites[i].live_bytes) {
+            if (pos < max) out[pos] = out[pos - 1];
+            pos--;
+        }
+        if (pos < max) out[pos] = sites[i];
+    }
+    heap_lock_release();
+    return count;
+}
+
+void heap_profile_dump() {
+    heap_profile_summary summary;
+    heap_profile_get_summary(&summary);
+
+    uint32_t buckets[HEAP_PROFILE_BUCKETS];
+    heap_lock_acquire();
+    for (int i = 0; i < HEAP_PROFILE_BUCKETS; i++) {
+        buckets[i] = histogram[i];
+    }
+    heap_lock_release();
+
+    serial_printf("Heap Profile - %d KB live in %d allocations, peak %d KB, %d allocations total\n",
+                  summary.live_bytes / 1024, summary.live_count,
+                  summary.peak_bytes / 1024, summary.total_count);
+    serial_printf("Fragmentation: largest free block %d KB of %d KB free (%d percent)\n",
+                  summary.largest_free / 1024, summary.free_bytes / 1024,
+                  percent_of(summary.largest_free, summary.free_bytes));
+    if (summary.untracked) {
+        serial_printf("  %d live allocations not attributed (side table full)\n", summary.untracked);
+    }
+
+    serial_printf("Size histogram:\n");
+    for (int i = 0; i < HEAP_PROFILE_BUCKETS; i++) {
+        if (buckets[i]) {
+            serial_printf("  %d-%d bytes: %d\n", 1u << i, (2u << i) - 1, buckets[i]);
+        }
+    }
+
+    heap_profile_site top[8];
+    int count = heap_profile_top_sites(top, 8);
+    serial_printf("Top call sites:\n");
+    for (int i = 0; i < count; i++) {
+        serial_printf("  0x%x: %d bytes live in %d allocations, %d total\n",
+                      top[i].caller, top[i].live_bytes, top[i].live_count, top[i].total_count);
+    }
+}
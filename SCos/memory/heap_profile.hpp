@@ -0,0 +1,34 @@
+#pragma once
+
+#include "../include/stddef.h"
+#include <stdint.h>
+
+// Live allocations tracked per caller; allocations beyond this still count
+// towards the totals but are not attributed to a call site
+#define HEAP_PROFILE_SLOTS 4096
+#define HEAP_PROFILE_SITES 128
+#define HEAP_PROFILE_BUCKETS 32
+
+struct heap_profile_site {
+    uint32_t caller;
+    uint32_t live_bytes;
+    uint32_t live_count;
+    uint32_t total_count;
+};
+
+struct heap_profile_summary {
+    uint32_t live_bytes;
+    uint32_t peak_bytes;
+    uint32_t live_count;
+    uint32_t total_count;
+    uint32_t untracked;
+    uint32_t free_bytes;
+    uint32_t largest_free;
+};
+
+bool init_heap_profile();
+void heap_profile_alloc(void* ptr, size_t request, uint32_t size, void* caller);
+void heap_profile_free(void* ptr, uint32_t size);
+void heap_profile_get_summary(heap_profile_summary* summary);
+int heap_profile_top_sites(heap_profile_site* sites, int max);
+void heap_profile_dump();
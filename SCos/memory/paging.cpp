@@ -0,0 +1,184 @@
+#include "paging.hpp"
+#include "pmm.hpp"
+#include "../debug/serial.hpp"
+#include "../debug/log.hpp"
+#include "../include/kernel.h"
+#include "../include/memory.h"
+#include "../interrupt/irq.hpp"
+#include "../kernel/spinlock.hpp"
+#include "../kernel/smp.hpp"
+
+#define PAGE_ENTRIES 1024
+#define LARGE_PAGE_SIZE (4 * 1024 * 1024)
+#define MAX_DEMAND_REGIONS 4
+
+// Physical memory is identity-mapped with 4 MB pages so the kernel, VGA
+// memory and every frame handed out by the frame allocator stay reachable
+// at their physical address. Everything above that is mapped with 4 KB
+// pages, either explicitly or lazily inside a demand-zero region.
+static uint32_t page_directory[PAGE_ENTRIES] __attribute__((aligned(PAGE_SIZE)));
+static uint32_t identity_limit = 0;
+
+struct demand_region {
+    uint32_t base;
+    uint32_t limit;
+};
+
+static demand_region demand_regions[MAX_DEMAND_REGIONS];
+static int demand_region_count = 0;
+static uint32_t demand_faults = 0;
+// Page tables are shared by every CPU. Faults take the lock too, hence
+// the irqsave variants.
+static lock_stats paging_lock_stats = LOCK_STATS_INIT("paging");
+static spinlock paging_lock = SPINLOCK_INIT_STATS(&paging_lock_stats);
+
+static inline void invalidate_page(uint32_t virt) {
+    asm volatile("invlpg (%0)" : : "r"(virt) : "memory");
+}
+
+static uint32_t* page_table_for(uint32_t virt, bool create) {
+    uint32_t& pde = page_directory[virt >> 22];
+    if (pde & PAGE_PRESENT) {
+        return (uint32_t*)(pde & ~(PAGE_SIZE - 1));
+    }
+    if (!create) return static_cast<uint32_t*>(nullptr);
+
+    uint32_t frame = pmm_alloc_frame();
+    if (!frame) return static_cast<uint32_t*>(nullptr);
+
+    uint32_t* table = (uint32_t*)frame;
+    for (int i = 0; i < PAGE_ENTRIES; i++) {
+        table[i] = 0;
+    }
+    pde = frame | PAGE_PRESENT | PAGE_WRITABLE;
+    return table;
+}
+
+static void page_fault_handler(interrupt_frame* frame);
+
+bool init_paging() {
+    uint32_t top = pmm_total_frames() * PAGE_SIZE;
+    if (top > HEAP_VIRT_BASE) top = HEAP_VIRT_BASE;
+    identity_limit = (top + LARGE_PAGE_SIZE - 1) & ~(LARGE_PAGE_SIZE - 1);
+
+    for (int i = 0; i < PAGE_ENTRIES; i++) {
+        page_directory[i] = 0;
+    }
+    for (uint32_t addr = 0; addr < identity_limit; addr += LARGE_PAGE_SIZE) {
+        page_directory[addr >> 22] = addr | PAGE_PRESENT | PAGE_WRITABLE | PAGE_LARGE;
+    }
+    demand_region_count = 0;
+    demand_faults = 0;
+    register_interrupt_handler(14, page_fault_handler);
+
+    asm volatile(
+        "mov %%cr4, %%eax\n"
+        "or $0x10, %%eax\n"          // CR4.PSE: allow 4 MB pages
+        "mov %%eax, %%cr4\n"
+        "mov %0, %%cr3\n"
+        "mov %%cr0, %%eax\n"
+        "or $0x80000000, %%eax\n"    // CR0.PG
+        "mov %%eax, %%cr0\n"
+        : : "r"((uint32_t)page_directory) : "eax", "memory");
+
+    log_info(LOG_MEMORY, "Paging enabled: identity mapped 0x0 - 0x%x\n", identity_limit);
+    return true;
+}
+
+static bool map_page_locked(uint32_t virt, uint32_t phys, uint32_t flags) {
+    uint32_t* table = page_table_for(virt, true);
+    if (!table) return false;
+
+    table[(virt >> 12) & (PAGE_ENTRIES - 1)] = (phys & ~(PAGE_SIZE - 1)) | flags | PAGE_PRESENT;
+    invalidate_page(virt);
+    return true;
+}
+
+bool paging_map_page(uint32_t virt, uint32_t phys, uint32_t flags) {
+    uint32_t lock_flags = spin_lock_irqsave(&paging_lock);
+    bool mapped = map_page_locked(virt, phys, flags);
+    spin_unlock_irqrestore(&paging_lock, lock_flags);
+    return mapped;
+}
+
+// Removes a 4 KB mapping and returns the frame it pointed at, or 0. The
+// shootdown waits for the other CPUs, so it runs after the lock is
+// dropped; one of them may be faulting on it.
+uint32_t paging_unmap_page(uint32_t virt) {
+    uint32_t flags = spin_lock_irqsave(&paging_lock);
+    uint32_t frame = 0;
+    uint32_t* table = page_table_for(virt, false);
+    if (table) {
+        uint32_t& pte = table[(virt >> 12) & (PAGE_ENTRIES - 1)];
+        if (pte & PAGE_PRESENT) {
+            frame = pte & ~(PAGE_SIZE - 1);
+            pte = 0;
+            invalidate_page(virt);
+        }
+    }
+    spin_unlock_irqrestore(&paging_lock, flags);
+
+    if (frame) smp_flush_tlb(virt);
+    return frame;
+}
+
+// Registers a virtual range whose pages get a fresh zeroed frame the first
+// time they are touched, so reserving address space costs nothing.
+bool paging_add_demand_region(uint32_t base, uint32_t size) {
+    if (demand_region_count >= MAX_DEMAND_REGIONS || base < identity_limit) {
+        return false;
+    }
+    demand_regions[demand_region_count].base = base;
+    demand_regions[demand_region_count].limit = base + size;
+    demand_region_count++;
+    return true;
+}
+
+static bool handle_demand_fault(uint32_t addr) {
+    for (int i = 0; i < demand_region_count; i++) {
+        if (addr < demand_regions[i].base || addr >= demand_regions[i].limit) continue;
+
+        uint32_t page = addr & ~(PAGE_SIZE - 1);
+        uint32_t flags = spin_lock_irqsave(&paging_lock);
+
+        // Another CPU may have faulted on the same page first
+        uint32_t* table = page_table_for(page, false);
+        if (table && (table[(page >> 12) & (PAGE_ENTRIES - 1)] & PAGE_PRESENT)) {
+            spin_unlock_irqrestore(&paging_lock, flags);
+            return true;
+        }
+
+        uint32_t frame = pmm_alloc_frame();
+        if (!frame || !map_page_locked(page, frame, PAGE_WRITABLE)) {
+            spin_unlock_irqrestore(&paging_lock, flags);
+            log_error(LOG_MEMORY, "Out of memory backing page 0x%x\n", page);
+            return false;
+        }
+
+        // Zeroed before the lock goes, so nobody sees the old contents
+        memset((void*)page, 0, PAGE_SIZE);
+        demand_faults++;
+        spin_unlock_irqrestore(&paging_lock, flags);
+        return true;
+    }
+    return false;
+}
+
+static void page_fault_handler(interrupt_frame* frame) {
+    uint32_t error_code = frame->error_code;
+    uint32_t addr;
+    asm volatile("mov %%cr2, %0" : "=r"(addr));
+
+    // Only not-present faults can be satisfied by backing a page
+    if (!(error_code & PAGE_PRESENT) && handle_demand_fault(addr)) {
+        return;
+    }
+
+    log_error(LOG_MEMORY, "Page fault at 0x%x from eip 0x%x, error code 0x%x\n",
+              addr, frame->eip, error_code);
+    kernel_panic("Unhandled page fault");
+}
+
+void paging_stats() {
+    serial_printf("Paging - %d demand-zero pages backed\n", demand_faults);
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include "../include/stddef.h"
+#include <stdint.h>
+
+#define PAGE_PRESENT 0x001
+#define PAGE_WRITABLE 0x002
+#define PAGE_USER 0x004
+#define PAGE_NOCACHE 0x010  // device registers
+#define PAGE_LARGE 0x080
+
+// Virtual window the heap lives in; its pages are backed on first touch.
+#define HEAP_VIRT_BASE 0xD0000000
+
+bool init_paging();
+bool paging_map_page(uint32_t virt, uint32_t phys, uint32_t flags);
+uint32_t paging_unmap_page(uint32_t virt);
+bool paging_add_demand_region(uint32_t base, uint32_t size);
+void paging_stats();
@@ -0,0 +1,192 @@
+#include "pmm.hpp"
+#include "../debug/serial.hpp"
+#include "../debug/log.hpp"
+#include "../kernel/spinlock.hpp"
+
+extern "C" {
+    extern uint32_t _kernel_end;
+}
+
+// One bit per physical frame, set = used. The bitmap is placed in the first
+// usable frames above the kernel so it scales with installed RAM.
+static uint32_t* frame_bitmap = nullptr;
+static uint32_t frame_count = 0;
+static uint32_t bitmap_words = 0;
+static uint32_t free_count = 0;
+// Word index the next top-down search starts from
+static uint32_t search_hint = 0;
+// Page faults allocate frames, so the lock is taken with interrupts off
+static lock_stats pmm_lock_stats = LOCK_STATS_INIT("frames");
+static spinlock pmm_lock = SPINLOCK_INIT_STATS(&pmm_lock_stats);
+
+static inline bool frame_used(uint32_t frame) {
+    return frame_bitmap[frame / 32] & (1u << (frame % 32));
+}
+
+static inline void frame_set(uint32_t frame) {
+    frame_bitmap[frame / 32] |= 1u << (frame % 32);
+}
+
+static inline void frame_clear(uint32_t frame) {
+    frame_bitmap[frame / 32] &= ~(1u << (frame % 32));
+}
+
+static void reserve_range(uint32_t base, uint32_t size) {
+    uint32_t first = base / PAGE_SIZE;
+    uint32_t last = (base + size + PAGE_SIZE - 1) / PAGE_SIZE;
+    for (uint32_t frame = first; frame < last && frame < frame_count; frame++) {
+        if (!frame_used(frame)) {
+            frame_set(frame);
+            free_count--;
+        }
+    }
+}
+
+static void release_range(uint64_t base, uint64_t length) {
+    uint64_t end = base + length;
+    if (end > 0x100000000ULL) end = 0x100000000ULL;
+
+    uint32_t first = (uint32_t)((base + PAGE_SIZE - 1) >> 12);
+    uint32_t last = (uint32_t)(end >> 12);
+    for (uint32_t frame = first; frame < last && frame < frame_count; frame++) {
+        if (frame_used(frame)) {
+            frame_clear(frame);
+            free_count++;
+        }
+    }
+}
+
+bool init_pmm() {
+    uint16_t entry_count = *(volatile uint16_t*)E820_MAP_ADDR;
+    e820_entry* map = (e820_entry*)(E820_MAP_ADDR + 4);
+
+    static e820_entry fallback = {0x100000, 15 * 1024 * 1024, E820_USABLE, 0};
+    if (entry_count == 0 || entry_count > E820_MAX_ENTRIES) {
+        log_warn(LOG_MEMORY, "No E820 memory map from bootloader, assuming 16 MB\n");
+        map = &fallback;
+        entry_count = 1;
+    }
+
+    uint64_t top = 0;
+    for (int i = 0; i < entry_count; i++) {
+        log_debug(LOG_MEMORY, "E820: base 0x%x length 0x%x type %d\n",
+                  (uint32_t)map[i].base, (uint32_t)map[i].length, map[i].type);
+        if (map[i].type != E820_USABLE) continue;
+
+        uint64_t end = map[i].base + map[i].length;
+        if (end > 0x100000000ULL) end = 0x100000000ULL;
+        if (end > top) top = end;
+    }
+
+    frame_count = (uint32_t)(top >> 12);
+    bitmap_words = (frame_count + 31) / 32;
+    uint32_t bitmap_bytes = bitmap_words * 4;
+
+    // Everything below 1 MB (IVT, BIOS data, kernel image, boot stack,
+    // VGA memory and ROMs) stays reserved.
+    uint32_t reserved_end = (uint32_t)&_kernel_end;
+    if (reserved_end < 0x100000) reserved_end = 0x100000;
+
+    frame_bitmap = nullptr;
+    for (int i = 0; i < entry_count && !frame_bitmap; i++) {
+        if (map[i].type != E820_USABLE) continue;
+
+        uint64_t start = map[i].base;
+        uint64_t end = map[i].base + map[i].length;
+        if (start < reserved_end) start = reserved_end;
+        start = (start + PAGE_SIZE - 1) & ~(uint64_t)(PAGE_SIZE - 1);
+
+        if (end > start && end - start >= bitmap_bytes && end <= 0x100000000ULL) {
+            frame_bitmap = (uint32_t*)(uint32_t)start;
+        }
+    }
+
+    if (!frame_bitmap) {
+        log_error(LOG_MEMORY, "No usable memory for the frame bitmap (%d bytes)\n", bitmap_bytes);
+        return false;
+    }
+
+    for (uint32_t i = 0; i < bitmap_words; i++) {
+        frame_bitmap[i] = 0xFFFFFFFF;
+    }
+    free_count = 0;
+
+    for (int i = 0; i < entry_count; i++) {
+        if (map[i].type == E820_USABLE) {
+            release_range(map[i].base, map[i].length);
+        }
+    }
+
+    reserve_range(0, reserved_end);
+    // Already inside the low megabyte, but APs keep starting from it
+    reserve_range(AP_TRAMPOLINE_ADDR, PAGE_SIZE);
+    reserve_range((uint32_t)frame_bitmap, bitmap_bytes);
+    search_hint = bitmap_words - 1;
+
+    log_info(LOG_MEMORY, "Physical memory: %d KB usable of %d KB, bitmap at 0x%x\n",
+             free_count * (PAGE_SIZE / 1024), frame_count * (PAGE_SIZE / 1024),
+             (uint32_t)frame_bitmap);
+    return true;
+}
+
+static uint32_t alloc_frame_locked() {
+    if (free_count == 0) return 0;
+
+    // Search down from the hint, then wrap around once from the top
+    for (uint32_t pass = 0; pass < 2; pass++) {
+        uint32_t word = pass == 0 ? search_hint : bitmap_words - 1;
+        for (;;) {
+            if (frame_bitmap[word] != 0xFFFFFFFF) {
+                uint32_t frame = word * 32 + 31 - __builtin_clz(~frame_bitmap[word]);
+                if (frame < frame_count) {
+                    frame_set(frame);
+                    free_count--;
+                    search_hint = word;
+                    return frame * PAGE_SIZE;
+                }
+            }
+            if (word == 0) break;
+            word--;
+        }
+    }
+
+    return 0;
+}
+
+uint32_t pmm_alloc_frame() {
+    uint32_t flags = spin_lock_irqsave(&pmm_lock);
+    uint32_t frame = alloc_frame_locked();
+    spin_unlock_irqrestore(&pmm_lock, flags);
+    return frame;
+}
+
+void pmm_free_frame(uint32_t frame_addr) {
+    uint32_t frame = frame_addr / PAGE_SIZE;
+    uint32_t flags = spin_lock_irqsave(&pmm_lock);
+    bool valid = frame < frame_count && frame_used(frame);
+    if (valid) {
+        frame_clear(frame);
+        free_count++;
+        if (frame / 32 > search_hint) {
+            search_hint = frame / 32;
+        }
+    }
+    spin_unlock_irqrestore(&pmm_lock, flags);
+
+    if (!valid) {
+        log_error(LOG_MEMORY, "Invalid frame free 0x%x\n", frame_addr);
+    }
+}
+
+uint32_t pmm_free_frames() {
+    return free_count;
+}
+
+uint32_t pmm_total_frames() {
+    return frame_count;
+}
+
+void pmm_stats() {
+    serial_printf("Physical Memory - %d KB free of %d KB (%d frames)\n",
+                  free_count * (PAGE_SIZE / 1024), frame_count * (PAGE_SIZE / 1024), frame_count);
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "../include/stddef.h"
+#include <stdint.h>
+
+#define PAGE_SIZE 4096
+
+// Where bootloader.asm leaves the BIOS E820 map: a 16-bit entry count
+// followed by 24-byte entries.
+#define E820_MAP_ADDR 0x500
+// Entries the bootloader keeps, so the map ends well below the kernel
+// image at 0x1000; must match E820_MAX in bootloader.asm
+#define E820_MAX_ENTRIES 32
+// Real-mode page that kernel/smp.cpp copies the AP startup trampoline to:
+// just above the boot stack, which grows down from 0x90000, and below the
+// EBDA
+#define AP_TRAMPOLINE_ADDR 0x90000
+#define E820_USABLE 1
+
+struct e820_entry {
+    uint64_t base;
+    uint64_t length;
+    uint32_t type;
+    uint32_t acpi_attributes;
+} __attribute__((packed));
+
+bool init_pmm();
+uint32_t pmm_alloc_frame();
+void pmm_free_frame(uint32_t frame);
+uint32_t pmm_free_frames();
+uint32_t pmm_total_frames();
+void pmm_stats();
@@ -24,6 +24,7 @@ echo "Starting SCos..."
 qemu-system-i386 \
     -drive format=raw,file=scos.img \
     -m 32M \
+    -smp 4 \
     -no-reboot \
     -no-shutdown \
     -vga std \
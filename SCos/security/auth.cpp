@@ -1,7 +1,9 @@
 #include "auth.hpp"
 #include "../ui/window_manager.hpp"
 #include "../drivers/keyboard.hpp"
+#include "../drivers/timer.hpp"
 #include "../debug/serial.hpp"
+#include "../include/kstring.hpp"
 
 #define MAX_USERS 10
 #define LOCKOUT_ATTEMPTS 3
@@ -60,34 +62,6 @@ static char stored_password_hash[33] = "";
 static int failed_login_attempts = 0;
 static bool security_authenticated = false;
 
-static int custom_strlen(const char* str) {
-    int len = 0;
-    while (str[len]) len++;
-    return len;
-}
-
-static void custom_strcpy(char* dest, const char* src) {
-    while (*src) {
-        *dest++ = *src++;
-    }
-    *dest = '\0';
-}
-
-static int custom_strcmp(const char* str1, const char* str2) {
-    while (*str1 && (*str1 == *str2)) {
-        str1++;
-        str2++;
-    }
-    return *(unsigned char*)str1 - *(unsigned char*)str2;
-}
-
-static void custom_memset(void* ptr, int value, int size) {
-    char* p = (char*)ptr;
-    for (int i = 0; i < size; i++) {
-        p[i] = value;
-    }
-}
-
 static void drawBackgroundPattern() {
     volatile char* video = (volatile char*)0xB8000;
 
@@ -154,7 +128,7 @@ static void drawLockScreen() {
     drawUserAvatar(center_x, avatar_y);
 
     int username_y = avatar_y + 4;
-    int username_len = custom_strlen(current_user);
+    int username_len = strlen(current_user);
     int username_x = center_x - (username_len / 2);
     for (int i = 0; current_user[i]; i++) {
         int idx = 2 * (username_y * 80 + username_x + i);
@@ -206,7 +180,7 @@ static void drawLockScreen() {
 
     const char* instruction = (current_auth_mode == AUTH_PIN) ? 
                               "Enter your PIN" : "Enter your password";
-    int instr_len = custom_strlen(instruction);
+    int instr_len = strlen(instruction);
     int instr_x = center_x - (instr_len / 2);
     int instr_y = input_y + 3;
     for (int i = 0; instruction[i]; i++) {
@@ -217,7 +191,7 @@ static void drawLockScreen() {
 
     if (caps_lock_on) {
         const char* caps_msg = "Caps Lock is on";
-        int caps_len = custom_strlen(caps_msg);
+        int caps_len = strlen(caps_msg);
         int caps_x = center_x - (caps_len / 2);
         int caps_y = instr_y + 2;
         for (int i = 0; caps_msg[i]; i++) {
@@ -228,7 +202,7 @@ static void drawLockScreen() {
     }
 
     const char* bottom_help = "Press Enter to sign in | ESC to switch user";
-    int help_len = custom_strlen(bottom_help);
+    int help_len = strlen(bottom_help);
     int help_x = center_x - (help_len / 2);
     int help_y = 22;
     for (int i = 0; bottom_help[i]; i++) {
@@ -238,7 +212,7 @@ static void drawLockScreen() {
     }
 
     const char* datetime = "Monday, December 15  12:45 PM";
-    int dt_len = custom_strlen(datetime);
+    int dt_len = strlen(datetime);
     int dt_x = 80 - dt_len - 2;
     int dt_y = 1;
     for (int i = 0; datetime[i]; i++) {
@@ -250,7 +224,7 @@ static void drawLockScreen() {
 
 uint32_t SecurityManager::simpleHash(const char* str) {
     uint32_t hash = 5381;
-    int len = custom_strlen(str);
+    int len = strlen(str);
     for (int i = 0; i < len; i++) {
         hash = ((hash << 5) + hash) + str[i];
     }
@@ -269,7 +243,7 @@ bool SecurityManager::verifyHash(const char* input, const char* stored_hash) {
 }
 
 bool SecurityManager::init() {
-    custom_memset(users, 0, sizeof(users));
+    memset(users, 0, sizeof(users));
     user_count = 0;
     system_locked = true;
     is_authenticated = false;
@@ -290,7 +264,7 @@ bool SecurityManager::init() {
 
 bool SecurityManager::authenticate(const char* input, AuthMode mode) {
     if (mode == AUTH_PIN) {
-        if (custom_strcmp(input, stored_pin) == 0) {
+        if (strcmp(input, stored_pin) == 0) {
             security_authenticated = true;
             failed_login_attempts = 0;
             return true;
@@ -330,8 +304,8 @@ bool SecurityManager::isSystemLocked() {
 }
 
 bool SecurityManager::changePin(const char* old_pin, const char* new_pin) {
-    if (custom_strcmp(old_pin, stored_pin) == 0) {
-        custom_strcpy(stored_pin, new_pin);
+    if (strcmp(old_pin, stored_pin) == 0) {
+        str_copy(stored_pin, sizeof(stored_pin), new_pin);
         return true;
     }
     return false;
@@ -353,7 +327,7 @@ bool SecurityManager::changePassword(const char* old_password, const char* new_p
 void SecurityManager::showLoginScreen() {
     lock_screen_visible = true;
     login_input_pos = 0;
-    custom_memset(login_input, 0, sizeof(login_input));
+    memset(login_input, 0, sizeof(login_input));
     drawLockScreen();
 }
 
@@ -369,7 +343,7 @@ void SecurityManager::handleLoginInput(uint8_t key) {
                     unlockSystem();
                 } else {
                     login_input_pos = 0;
-                    custom_memset(login_input, 0, sizeof(login_input));
+                    memset(login_input, 0, sizeof(login_input));
                     drawLockScreen();
                 }
             }
@@ -378,7 +352,7 @@ void SecurityManager::handleLoginInput(uint8_t key) {
         case 0x01:
             current_auth_mode = (current_auth_mode == AUTH_PIN) ? AUTH_PASSWORD : AUTH_PIN;
             login_input_pos = 0;
-            custom_memset(login_input, 0, sizeof(login_input));
+            memset(login_input, 0, sizeof(login_input));
             drawLockScreen();
             break;
 
@@ -460,7 +434,7 @@ void SecurityManager::drawLoginScreen() {
 
 void SecurityManager::clearLoginInput() {
     login_input_pos = 0;
-    custom_memset(login_input, 0, sizeof(login_input));
+    memset(login_input, 0, sizeof(login_input));
 }
 
 void SecurityManager::drawSecurityStatus() {
@@ -468,7 +442,7 @@ void SecurityManager::drawSecurityStatus() {
 
 void AuthSystem::hashPassword(const char* password, char* hash) {
     uint32_t h = 5381;
-    int len = custom_strlen(password);
+    int len = strlen(password);
 
     for (int i = 0; i < len; i++) {
         h = ((h << 5) + h) + password[i];
@@ -484,17 +458,17 @@ void AuthSystem::hashPassword(const char* password, char* hash) {
 bool AuthSystem::verifyPassword(const char* password, const char* stored_hash) {
     char computed_hash[9];
     hashPassword(password, computed_hash);
-    return custom_strcmp(computed_hash, stored_hash) == 0;
+    return strcmp(computed_hash, stored_hash) == 0;
 }
 
+// Seconds since boot
 uint32_t AuthSystem::getCurrentTime() {
-    static uint32_t tick = 0;
-    return ++tick;
+    return ktime_ms() / 1000;
 }
 
 struct User* AuthSystem::findUser(const char* username) {
     for (int i = 0; i < user_count; i++) {
-        if (custom_strcmp(users[i].username, username) == 0) {
+        if (strcmp(users[i].username, username) == 0) {
             return &users[i];
         }
     }
@@ -502,7 +476,7 @@ struct User* AuthSystem::findUser(const char* username) {
 }
 
 void AuthSystem::init() {
-    custom_memset(users, 0, sizeof(users));
+    memset(users, 0, sizeof(users));
     user_count = 0;
     system_locked = true;
     is_authenticated = false;
@@ -518,7 +492,7 @@ void AuthSystem::init() {
 bool AuthSystem::showLockScreen() {
     lock_screen_visible = true;
     login_input_pos = 0;
-    custom_memset(login_input, 0, sizeof(login_input));
+    memset(login_input, 0, sizeof(login_input));
 
     drawLockScreen();
     return true;
@@ -549,7 +523,7 @@ void AuthSystem::handleLockScreenInput(uint8_t key) {
                     }
                 } else {
                     login_input_pos = 0;
-                    custom_memset(login_input, 0, sizeof(login_input));
+                    memset(login_input, 0, sizeof(login_input));
                     drawLockScreen();
                 }
             }
@@ -559,7 +533,7 @@ void AuthSystem::handleLockScreenInput(uint8_t key) {
             system_security_level = (system_security_level == SECURITY_PIN) ? 
                                    SECURITY_PASSWORD : SECURITY_PIN;
             login_input_pos = 0;
-            custom_memset(login_input, 0, sizeof(login_input));
+            memset(login_input, 0, sizeof(login_input));
             drawLockScreen();
             break;
 
@@ -659,14 +633,14 @@ int AuthSystem::authenticateUser(const char* username, const char* credential) {
 
     bool auth_success = false;
     if (system_security_level == SECURITY_PIN) {
-        auth_success = custom_strcmp(user->pin, credential) == 0;
+        auth_success = strcmp(user->pin, credential) == 0;
     } else {
         auth_success = verifyPassword(credential, user->password);
     }
 
     if (auth_success) {
         clearFailedAttempts(username);
-        custom_strcpy(current_user, username);
+        str_copy(current_user, sizeof(current_user), username);
         is_authenticated = true;
         logSecurityEvent("Successful login", username);
         return AUTH_SUCCESS;
@@ -686,18 +660,18 @@ int AuthSystem::authenticatePin(const char* pin) {
         return AUTH_SYSTEM_LOCKED;
     }
 
-    if (custom_strcmp(pin, SYSTEM_DEFAULT_PIN) == 0) {
-        custom_strcpy(current_user, "system");
+    if (strcmp(pin, SYSTEM_DEFAULT_PIN) == 0) {
+        str_copy(current_user, sizeof(current_user), "system");
         is_authenticated = true;
         logSecurityEvent("System PIN authentication", "SYSTEM");
         return AUTH_SUCCESS;
     }
 
     for (int i = 0; i < user_count; i++) {
-        if (users[i].is_active && custom_strcmp(users[i].pin, pin) == 0) {
+        if (users[i].is_active && strcmp(users[i].pin, pin) == 0) {
             if (!isUserLocked(users[i].username)) {
                 clearFailedAttempts(users[i].username);
-                custom_strcpy(current_user, users[i].username);
+                str_copy(current_user, sizeof(current_user), users[i].username);
                 is_authenticated = true;
                 logSecurityEvent("PIN authentication", users[i].username);
                 return AUTH_SUCCESS;
@@ -714,9 +688,9 @@ bool AuthSystem::createUser(const char* username, const char* password, const ch
     if (findUser(username)) return false;
 
     User* user = &users[user_count++];
-    custom_strcpy(user->username, username);
+    str_copy(user->username, sizeof(user->username), username);
     hashPassword(password, user->password);
-    custom_strcpy(user->pin, pin);
+    str_copy(user->pin, sizeof(user->pin), pin);
     user->security_level = SECURITY_PIN;
     user->is_admin = is_admin;
     user->is_active = true;
@@ -744,7 +718,7 @@ void AuthSystem::unlockSystem() {
 void AuthSystem::logSecurityEvent(const char* event, const char* username) {
     if (log_count >= MAX_LOG_ENTRIES) {
         for (int i = 0; i < MAX_LOG_ENTRIES - 1; i++) {
-            custom_strcpy(security_log[i], security_log[i + 1]);
+            str_copy(security_log[i], sizeof(security_log[i]), security_log[i + 1]);
         }
         log_count = MAX_LOG_ENTRIES - 1;
     }
@@ -761,21 +735,11 @@ void AuthSystem::logSecurityEvent(const char* event, const char* username) {
     log_entry[pos++] = ']';
     log_entry[pos++] = ' ';
 
-    int event_len = custom_strlen(event);
-    for (int i = 0; i < event_len && pos < 70; i++) {
-        log_entry[pos++] = event[i];
-    }
-
-    log_entry[pos++] = ' ';
-    log_entry[pos++] = '-';
-    log_entry[pos++] = ' ';
-
-    int user_len = custom_strlen(username);
-    for (int i = 0; i < user_len && pos < 79; i++) {
-        log_entry[pos++] = username[i];
-    }
-
+    // The event text is capped at column 70 so the user name still fits
     log_entry[pos] = '\0';
+    pos = str_append(log_entry, 71, pos, event);
+    pos = str_append(log_entry, sizeof(security_log[0]), pos, " - ");
+    str_append(log_entry, sizeof(security_log[0]), pos, username);
 }
 
 bool AuthSystem::hasAdminPrivileges(const char* username) {
@@ -811,7 +775,7 @@ void AuthSystem::showSecurityLog() {
     }
 
     const char* title = "Security Event Log";
-    int title_len = custom_strlen(title);
+    int title_len = strlen(title);
     int title_x = win->x + (win->width - title_len) / 2;
     for (int i = 0; i < title_len; i++) {
         int idx = 2 * ((win->y + 1) * 80 + title_x + i);
@@ -824,7 +788,7 @@ void AuthSystem::showSecurityLog() {
 
     for (int i = 0; i < display_count; i++) {
         const char* entry = security_log[start_entry + i];
-        int entry_len = custom_strlen(entry);
+        int entry_len = strlen(entry);
         int max_len = (entry_len < win->width - 4) ? entry_len : win->width - 4;
 
         for (int j = 0; j < max_len; j++) {
@@ -835,7 +799,7 @@ void AuthSystem::showSecurityLog() {
     }
 
     const char* footer = "Press any key to close";
-    int footer_len = custom_strlen(footer);
+    int footer_len = strlen(footer);
     for (int i = 0; i < footer_len; i++) {
         int idx = 2 * ((win->y + win->height - 2) * 80 + win->x + 2 + i);
         video[idx] = footer[i];
@@ -12,20 +12,7 @@
 #include "../apps/updates.hpp"
 #include "../apps/security_center.hpp"
 #include "../apps/network_settings.hpp"
-
-static int custom_strlen(const char* str) {
-    int len = 0;
-    while (str[len]) len++;
-    return len;
-}
-
-static int custom_strcmp(const char* str1, const char* str2) {
-    while (*str1 && (*str1 == *str2)) {
-        str1++;
-        str2++;
-    }
-    return *(unsigned char*)str1 - *(unsigned char*)str2;
-}
+#include "../include/kstring.hpp"
 
 #define MAX_APPS 16
 #define LAUNCHER_WIDTH 60
@@ -149,14 +136,14 @@ void AppLauncher::drawAppIcon(int x, int y, const AppInfo& app, bool selected) {
         }
     }
 
-    int icon_len = custom_strlen(app.icon);
+    int icon_len = strlen(app.icon);
     for (int i = 0; i < icon_len && i < 10; ++i) {
         int idx = 2 * (y * 80 + x + i);
         video[idx] = app.icon[i];
         video[idx + 1] = text_color;
     }
 
-    int name_len = custom_strlen(app.name);
+    int name_len = strlen(app.name);
     for (int i = 0; i < name_len && i < 10; ++i) {
         int idx = 2 * ((y + 1) * 80 + x + i);
         video[idx] = app.name[i];
@@ -257,7 +244,7 @@ void AppLauncher::handleMouseClick(int x, int y) {
 
 void AppLauncher::launchAppByName(const char* name) {
     for (int i = 0; i < app_count; ++i) {
-        if (custom_strcmp(registered_apps[i].name, name) == 0) {
+        if (strcmp(registered_apps[i].name, name) == 0) {
             launchApp(i);
             return;
         }
@@ -16,6 +16,9 @@
 #include "../security/auth.hpp"
 #include "../drivers/keyboard.hpp"
 #include "../drivers/mouse.hpp"
+#include "../drivers/timer.hpp"
+#include "../debug/trace.hpp"
+#include "../include/string.h"
 
 static bool desktop_initialized = false;
 static bool running = true;
@@ -90,7 +93,16 @@ void Desktop::drawTaskbar() {
     int app_start_x = 7;
     drawOpenAppIcons(app_start_x, taskbar_y);
 
-    const char* date_text = "Dec 15";
+    static const char* const month_names[12] = {
+        "Jan", "Feb", "Mar", "Apr", "May", "Jun",
+        "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"
+    };
+    clock_time now;
+    clock_read(&now);
+    const char* month = now.month >= 1 && now.month <= 12 ? month_names[now.month - 1] : "???";
+
+    char date_text[8];
+    snprintf(date_text, sizeof(date_text), "%s %d", month, now.day);
     int date_x = 80 - 12;
     for (int i = 0; date_text[i]; ++i) {
         int idx = 2 * (taskbar_y * 80 + date_x + i);
@@ -98,7 +110,8 @@ void Desktop::drawTaskbar() {
         video[idx + 1] = theme.foreground_color;
     }
 
-    const char* time_text = "12:45";
+    char time_text[6];
+    snprintf(time_text, sizeof(time_text), "%02d:%02d", now.hour, now.minute);
     int time_x = 80 - 5;
     for (int i = 0; time_text[i]; ++i) {
         int idx = 2 * (taskbar_y * 80 + time_x + i);
@@ -159,10 +172,7 @@ void Desktop::openAppStore() {
 }
 
 void Desktop::runTerminal() {
-    int term_id = WindowManager::createWindow("Terminal", 10, 5, 60, 15);
-    if (term_id >= 0) {
-        WindowManager::setActiveWindow(term_id);
-    }
+    ::runTerminal();
 }
 
 void Desktop::openNotepad(const char* content) {
@@ -215,6 +225,16 @@ void Desktop::openSecurityCenter() {
 }
 
 void Desktop::handleInput() {
+    // The terminal takes every typed character while it has focus, rather
+    // than the last key the other apps poll for
+    if (terminalHasFocus() && !AuthSystem::isLockScreenVisible() && !AppLauncher::isVisible()) {
+        while (Keyboard::hasKey()) {
+            handleTerminalInput(Keyboard::getKey());
+        }
+        handleMouseInput();
+        return;
+    }
+
     uint8_t key = Keyboard::getLastKey();
     if (key != 0) {
         if (AuthSystem::isLockScreenVisible()) {
@@ -278,7 +298,9 @@ void Desktop::handleInput() {
 }
 
 void Desktop::handle_events() {
+    TRACE(TRACE_DESKTOP_EVENTS_BEGIN, 0);
     handleInput();
+    TRACE(TRACE_DESKTOP_EVENTS_END, 0);
 }
 
 void Desktop::update() {
@@ -364,6 +386,7 @@ void Desktop::handleTaskbarClick(int x) {
 
 void Desktop::updateDesktop() {
     WindowManager::refreshAll();
+    drawTerminalContent();
 
     drawTaskbar();
 
@@ -1,10 +1,20 @@
 #include "theme_manager.hpp"
 #include "window_manager.hpp"
+#include "../kernel/ktimer.hpp"
 
 static ThemeType current_theme = THEME_MATRIX_GREEN;
 static Theme themes[THEME_COUNT];
 static bool themes_initialized = false;
 
+// Matrix background animation frame, advanced by a timer
+#define MATRIX_FRAME_MS 150
+static int matrix_offset = 0;
+static ktimer matrix_timer;
+
+static void advanceMatrix(void*) {
+    matrix_offset = (matrix_offset + 1) % 100;
+}
+
 void ThemeManager::init() {
     if (!themes_initialized) {
         initializeThemes();
@@ -149,7 +159,13 @@ void ThemeManager::drawMatrixBackground(uint8_t color) {
     }
 
     const char matrix_chars[] = "01アイウエオカキクケコサシスセソタチツテトナニヌネノハヒフヘホマミムメモヤユヨラリルレロワヲン";
-    static int offset = 0;
+
+    // Animate at a fixed rate however often the desktop redraws
+    if (!ktimer_pending(&matrix_timer)) {
+        ktimer_init(&matrix_timer, advanceMatrix, nullptr);
+        ktimer_start(&matrix_timer, MATRIX_FRAME_MS);
+    }
+    int offset = matrix_offset;
 
     for (int x = 0; x < 80; x += 8) {
         for (int y = 0; y < 25; y += 3) {
@@ -163,7 +179,6 @@ void ThemeManager::drawMatrixBackground(uint8_t color) {
             }
         }
     }
-    offset = (offset + 1) % 100;
 }
 
 void ThemeManager::drawNatureBackground() {
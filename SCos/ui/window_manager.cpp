@@ -2,20 +2,25 @@
 #include <stdint.h>
 
 #include "vga_utils.hpp"
-
-static int strlen(const char* str) {
-    int len = 0;
-    while (str[len]) len++;
-    return len;
-}
+#include "../debug/trace.hpp"
+#include "../kernel/rwlock.hpp"
+#include "../include/kstring.hpp"
 
 const int VGA_WIDTH = 80;
 const int VGA_HEIGHT = 25;
 static volatile char* video_memory = (volatile char*)0xB8000;
 
+// Drawing reads the table and the rest rewrites it, so the table is
+// guarded by a reader-writer lock. The lock covers the table itself;
+// callers of getWindow() own what they do with the pointer.
 static Window windows[MAX_WINDOWS];
 static int window_count = 0;
 static int active_window = -1;
+static lock_stats windows_lock_stats = LOCK_STATS_INIT("windows");
+static rwlock windows_lock = RWLOCK_INIT_STATS(&windows_lock_stats);
+
+static void draw_window(int window_id);
+static void clear_window_area(int x, int y, int width, int height);
 
 void WindowManager::init() {
     window_count = 0;
@@ -31,7 +36,9 @@ void WindowManager::clearScreen() {
 }
 
 int WindowManager::createWindow(const char* title, int x, int y, int width, int height) {
+    write_lock(&windows_lock);
     if (window_count >= MAX_WINDOWS) {
+        write_unlock(&windows_lock);
         return -1;
     }
 
@@ -51,16 +58,26 @@ int WindowManager::createWindow(const char* title, int x, int y, int width, int
     }
     windows[id].title[i] = '\0';
 
-    drawWindow(id);
+    draw_window(id);
+    write_unlock(&windows_lock);
     return id;
 }
 
 void WindowManager::drawWindow(int window_id) {
+    read_lock(&windows_lock);
+    draw_window(window_id);
+    read_unlock(&windows_lock);
+}
+
+// Callers hold windows_lock
+static void draw_window(int window_id) {
     if (window_id < 0 || window_id >= window_count) return;
 
     Window& win = windows[window_id];
     if (!win.visible) return;
 
+    TRACE(TRACE_DRAW_WINDOW_BEGIN, window_id);
+
     uint8_t border_color = win.focused ? 0x4F : 0x70;
     uint8_t bg_color = 0x17;
     uint8_t title_color = 0x4F;
@@ -84,65 +101,75 @@ void WindowManager::drawWindow(int window_id) {
         }
     }
 
-    int title_len = strlen(win.title);
+    int title_len = (int)strlen(win.title);
     int title_start = win.x + 2;
     for (int i = 0; i < title_len && i < win.width - 4; ++i) {
         int idx = 2 * (win.y * VGA_WIDTH + title_start + i);
         video_memory[idx] = win.title[i];
         video_memory[idx + 1] = title_color;
     }
+
+    TRACE(TRACE_DRAW_WINDOW_END, window_id);
 }
 
 void WindowManager::closeWindow(int window_id) {
-    if (window_id < 0 || window_id >= window_count) return;
-
-    windows[window_id].visible = false;
-    clearWindowArea(windows[window_id].x, windows[window_id].y, 
-                   windows[window_id].width, windows[window_id].height);
-
-    if (active_window == window_id) {
-        active_window = -1;
+    write_lock(&windows_lock);
+    if (window_id >= 0 && window_id < window_count) {
+        windows[window_id].visible = false;
+        clear_window_area(windows[window_id].x, windows[window_id].y,
+                          windows[window_id].width, windows[window_id].height);
+
+        if (active_window == window_id) {
+            active_window = -1;
+        }
     }
+    write_unlock(&windows_lock);
 }
 
 void WindowManager::moveWindow(int window_id, int x, int y) {
-    if (window_id < 0 || window_id >= window_count) return;
-
-    clearWindowArea(windows[window_id].x, windows[window_id].y,
-                   windows[window_id].width, windows[window_id].height);
+    write_lock(&windows_lock);
+    if (window_id >= 0 && window_id < window_count) {
+        clear_window_area(windows[window_id].x, windows[window_id].y,
+                          windows[window_id].width, windows[window_id].height);
 
-    windows[window_id].x = x;
-    windows[window_id].y = y;
+        windows[window_id].x = x;
+        windows[window_id].y = y;
 
-    drawWindow(window_id);
+        draw_window(window_id);
+    }
+    write_unlock(&windows_lock);
 }
 
 void WindowManager::resizeWindow(int window_id, int width, int height) {
-    if (window_id < 0 || window_id >= window_count) return;
+    write_lock(&windows_lock);
+    if (window_id >= 0 && window_id < window_count) {
+        clear_window_area(windows[window_id].x, windows[window_id].y,
+                          windows[window_id].width, windows[window_id].height);
 
-    clearWindowArea(windows[window_id].x, windows[window_id].y,
-                   windows[window_id].width, windows[window_id].height);
+        windows[window_id].width = width;
+        windows[window_id].height = height;
 
-    windows[window_id].width = width;
-    windows[window_id].height = height;
-
-    drawWindow(window_id);
+        draw_window(window_id);
+    }
+    write_unlock(&windows_lock);
 }
 
 void WindowManager::setActiveWindow(int window_id) {
-    if (window_id < 0 || window_id >= window_count) return;
+    write_lock(&windows_lock);
+    if (window_id >= 0 && window_id < window_count) {
+        if (active_window >= 0 && active_window < window_count) {
+            windows[active_window].focused = false;
+            draw_window(active_window);
+        }
 
-    if (active_window >= 0 && active_window < window_count) {
-        windows[active_window].focused = false;
-        drawWindow(active_window);
+        active_window = window_id;
+        windows[window_id].focused = true;
+        draw_window(window_id);
     }
-
-    active_window = window_id;
-    windows[window_id].focused = true;
-    drawWindow(window_id);
+    write_unlock(&windows_lock);
 }
 
-void WindowManager::clearWindowArea(int x, int y, int width, int height) {
+static void clear_window_area(int x, int y, int width, int height) {
     for (int j = 0; j < height; ++j) {
         for (int i = 0; i < width; ++i) {
             int screen_x = x + i;
@@ -167,10 +194,12 @@ int WindowManager::getActiveWindow() {
 }
 
 void WindowManager::refreshAll() {
+    read_lock(&windows_lock);
     clearScreen();
     for (int i = 0; i < window_count; ++i) {
         if (windows[i].visible) {
-            drawWindow(i);
+            draw_window(i);
         }
     }
+    read_unlock(&windows_lock);
 }
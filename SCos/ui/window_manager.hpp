@@ -29,9 +29,6 @@ public:
     static int getActiveWindow();
     static Window* getWindow(int id);
     static void refreshAll();
-    
-private:
-    static void clearWindowArea(int x, int y, int width, int height);
 };
 
 